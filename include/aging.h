@@ -0,0 +1,29 @@
+#ifndef __AGING_H_
+#define __AGING_H_
+
+#include <cstdint>
+
+// Priority aging for PP. A ready process's effective priority improves by one
+// level for every `interval` it has been waiting, down to 0. Queues are not
+// rescanned as time passes: they are ordered by the fixed key
+//     priority * interval + ready_since
+// and because every waiting process's effective priority falls at the same
+// rate, that order is the effective priority order at any later instant.
+// Callers pick the time unit (ms in osscheduler, us in the simulators).
+
+inline uint64_t AgingKey(uint8_t priority, uint64_t ready_since, uint64_t interval)
+{
+    return (uint64_t)priority * interval + ready_since;
+}
+
+inline uint8_t AgedPriority(uint8_t priority, uint64_t ready_since, uint64_t now, uint64_t interval)
+{
+    if (interval == 0 || now <= ready_since)
+    {
+        return priority;
+    }
+    uint64_t boost = (now - ready_since) / interval;
+    return (boost >= priority) ? 0 : priority - boost;
+}
+
+#endif // __AGING_H_
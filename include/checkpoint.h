@@ -0,0 +1,58 @@
+#ifndef __CHECKPOINT_H_
+#define __CHECKPOINT_H_
+
+#include <cstdint>
+#include <vector>
+#include "configreader.h"
+#include "process.h"
+
+#define CHECKPOINT_MAGIC 0x4b43534f
+#define CHECKPOINT_VERSION 7
+
+// Binary snapshot of a running threaded simulation. The file is the header
+// followed by each vector's raw contents in declaration order; lengths are in
+// the header. Bursts for every process are stored back to back, in process
+// table order, so a resume does not need the original configuration file;
+// they are the process table's own burst pool, shared rather than copied.
+typedef struct CheckpointHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t cores;
+    uint32_t context_switch;
+    uint32_t time_slice;
+    uint32_t migration_penalty;
+    uint32_t cache_decay;
+    uint32_t aging_interval;
+    uint32_t max_ready;
+    uint32_t deferred_count;
+    uint32_t peak_ready;
+    uint8_t admission;
+    uint8_t placement;
+    uint8_t speed_scaled;
+    uint16_t affinity_window;
+    uint8_t algorithm;
+    uint8_t half_flag;
+    uint32_t clock_ms;
+    uint32_t num_processes;
+    uint32_t num_bursts;
+    uint32_t ready_queue_len;
+    uint32_t context_switches;
+    double time_half;
+    double throughput_first_half;
+} CheckpointHeader;
+
+typedef struct Checkpoint {
+    CheckpointHeader header;
+    std::vector<ProcessSnapshot> processes;
+    BurstPool bursts;
+    std::vector<uint32_t> ready_queue;
+    std::vector<uint64_t> core_busy_us;
+    std::vector<uint32_t> core_migrations;
+    std::vector<uint64_t> core_migration_us;
+    std::vector<double> core_speeds;
+} Checkpoint;
+
+bool WriteCheckpoint(const char *filename, const Checkpoint &checkpoint);
+bool ReadCheckpoint(const char *filename, Checkpoint *checkpoint);
+
+#endif // __CHECKPOINT_H_
@@ -5,27 +5,45 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <vector>
 
 enum ScheduleAlgorithm : uint8_t { RR, FCFS, SJF, PP };
+enum AdmissionPolicy : uint8_t { Defer, Reject };
+enum Placement : uint8_t { Any, Speed };
+
+// Burst times of every process, back to back in one allocation. Processes
+// point into it rather than copying their bursts out, and hold a reference
+// so it outlives the configuration it was read with.
+typedef std::shared_ptr<const std::vector<uint32_t> > BurstPool;
 
 typedef struct ProcessDetails {
-    uint16_t pid;
+    uint32_t pid;
     uint32_t start_time;
     uint16_t num_bursts;
-    uint32_t *burst_times;
+    const uint32_t *burst_times;
     uint8_t priority;
 } ProcessDetails;
 
 typedef struct SchedulerConfig {
-    uint8_t cores;
+    uint16_t cores;
     ScheduleAlgorithm algorithm;
     uint32_t context_switch;
     uint32_t time_slice;
-    uint16_t num_processes;
-    ProcessDetails *processes;
+    uint32_t num_processes;
+    std::vector<ProcessDetails> processes;
+    BurstPool bursts;
+    uint32_t migration_penalty;
+    uint32_t cache_decay;
+    uint16_t affinity_window;
+    uint32_t aging_interval;
+    uint32_t migration_latency;
+    uint32_t max_ready;
+    AdmissionPolicy admission;
+    std::vector<double> core_speeds;
+    Placement placement;
 } SchedulerConfig;
 
-void ReadConfigFile(const char *filename, SchedulerConfig **config);
-void DeleteConfig(SchedulerConfig **config);
+std::unique_ptr<SchedulerConfig> ReadConfigFile(const char *filename);
 
 #endif // __CONFIGREADER_H_
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef __DECISIONLOG_H_
+#define __DECISIONLOG_H_
+
+#include <cstdio>
+#include <cstdint>
+#include "configreader.h"
+
+#define DECISIONLOG_MAGIC 0x474c4453
+#define DECISIONLOG_VERSION 2
+
+// Compact binary log of scheduling decisions: one fixed-size record each time
+// a process is put on a core. The header identifies the run (engine, seed,
+// configuration hash) so a replay can rebuild it; the records are what a
+// replay or a second run is checked against.
+
+typedef struct DecisionLogHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t cores;
+    uint8_t algorithm;
+    uint8_t engine;
+    uint16_t threads;
+    uint32_t reserved;
+    uint64_t seed;
+    uint64_t lookahead;
+    uint64_t config_hash;
+} DecisionLogHeader;
+
+typedef struct DecisionRecord {
+    uint64_t time_us;
+    uint32_t pid;
+    uint32_t core;
+} DecisionRecord;
+
+class DecisionLog {
+public:
+    enum Mode : uint8_t {Write, Read, Verify};
+    enum Engine : uint8_t {Global, Partitioned, Threaded};
+
+private:
+    FILE *file;
+    Mode mode;
+    DecisionRecord *buffer;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t fill;
+    uint64_t count;
+    bool diverged;
+    uint64_t divergence;
+    bool has_expected;
+    bool has_actual;
+    DecisionRecord expected;
+    DecisionRecord actual;
+
+    bool Refill();
+    void Flush();
+
+public:
+    DecisionLog();
+    ~DecisionLog();
+
+    // Write creates the file and stores *header; Read and Verify load *header
+    bool Open(const char *filename, Mode mode, DecisionLogHeader *header);
+    void Record(uint64_t time_us, uint32_t pid, uint32_t core);
+    bool Next(DecisionRecord *record);
+    bool Close();
+
+    uint64_t GetCount();
+    bool Diverged();
+    uint64_t GetDivergence();
+    bool HasExpected();
+    bool HasActual();
+    DecisionRecord GetExpected();
+    DecisionRecord GetActual();
+};
+
+uint64_t HashConfig(SchedulerConfig *config);
+
+#endif // __DECISIONLOG_H_
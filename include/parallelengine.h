@@ -0,0 +1,214 @@
+#ifndef __PARALLELENGINE_H_
+#define __PARALLELENGINE_H_
+
+#include <coroutine>
+#include <queue>
+#include <vector>
+#include "configreader.h"
+#include "process.h"
+#include "simengine.h"
+#include "decisionlog.h"
+
+// Conservative parallel discrete-event engine (C++20).
+//
+// Unlike SimEngine's single ready queue, every simulated core has its own run
+// queue. Cores are split into contiguous partitions, one per host thread.
+// The only cross-core interaction is a process migrating to another core after
+// an I/O burst, which takes the model's migration latency to arrive. That
+// latency is also the lookahead: windows cover [k * latency, (k + 1) * latency)
+// and each partition runs a window on its own, since nothing sent inside it
+// can arrive before its end. Placement reads per-core loads captured at the
+// window boundary; windows are aligned to the latency grid rather than to the
+// next event, so those boundaries are part of the model, not of the run.
+//
+// Events are ordered by (time, core, kind, process index) and placement uses
+// hashes of the seed, so results do not depend on the number of host threads.
+
+class ParallelEngine {
+public:
+    enum EventKind : uint8_t {Resume, RunEnd, SwitchDone};
+
+private:
+    typedef struct PEvent {
+        SimTime time;
+        std::coroutine_handle<> handle;
+        uint32_t id;
+        uint32_t gen;
+        uint16_t core;
+        EventKind kind;
+    } PEvent;
+
+    typedef struct PReadyEntry {
+        double key;
+        uint64_t seq;
+        SimTime since;
+        Process *process;
+        std::coroutine_handle<> handle;
+    } PReadyEntry;
+
+    struct PEventLater {
+        bool operator()(const PEvent &a, const PEvent &b) const
+        {
+            if (a.time != b.time) return a.time > b.time;
+            if (a.core != b.core) return a.core > b.core;
+            if (a.kind != b.kind) return a.kind > b.kind;
+            return a.id > b.id;
+        }
+    };
+    struct PEntryLater {
+        bool operator()(const PReadyEntry &a, const PReadyEntry &b) const
+        {
+            return (a.key != b.key) ? a.key > b.key : a.seq > b.seq;
+        }
+    };
+
+    typedef struct PCore {
+        std::priority_queue<PReadyEntry, std::vector<PReadyEntry>, PEntryLater> ready;
+        Process *running;
+        std::coroutine_handle<> handle;
+        SimTime run_start;
+        SimTime run_end;
+        uint32_t result_ms;
+        uint32_t gen;
+        bool preempting;
+        bool switching;
+        bool has_pending;
+        PReadyEntry pending;
+        uint64_t seq;
+        uint64_t busy_us;
+        uint32_t context_switches;
+        uint32_t migrations;
+        uint32_t peak_ready;
+        std::vector<DecisionRecord> decisions;
+    } PCore;
+
+    typedef struct Message {
+        SimTime time;
+        std::coroutine_handle<> handle;
+        uint32_t id;
+        uint16_t core;
+    } Message;
+
+    typedef struct alignas(64) Partition {
+        uint16_t first_core;
+        uint16_t last_core;
+        SimTime now;
+        SimTime next_time;
+        uint64_t events_processed;
+        std::priority_queue<PEvent, std::vector<PEvent>, PEventLater> events;
+        std::vector<Message> outbox;
+        std::vector<SimTime> completions;
+    } Partition;
+
+    uint16_t cores;
+    uint16_t threads;
+    uint16_t cores_per_partition;
+    ScheduleAlgorithm algorithm;
+    uint32_t context_switch;
+    uint32_t time_slice;
+    SimTime migration_latency;
+    SimTime lookahead;
+    uint64_t seed;
+    SimTime window_end;
+    uint64_t windows;
+    bool done;
+    bool log_decisions;
+    SimTime aging_interval;
+    std::vector<PCore> core;
+    std::vector<Partition> partition;
+    std::vector<uint32_t> load;
+    std::vector<SimTime> completions;
+
+    Partition* PartitionOf(uint16_t core_id);
+    void Schedule(uint16_t core_id, SimTime time, EventKind kind, std::coroutine_handle<> handle, uint32_t id, uint32_t gen);
+    void Enqueue(uint16_t core_id, Process *p, std::coroutine_handle<> handle);
+    void Dispatch(uint16_t core_id);
+    void CheckPreempt(uint16_t core_id, Process *p);
+    void HandleRunEnd(const PEvent &e);
+    void ProcessWindow(uint16_t k);
+    void Deliver(uint16_t k);
+    void EndWindow();
+    void Worker(uint16_t k);
+
+public:
+    struct DelayAwaiter {
+        ParallelEngine *sim;
+        uint16_t core_id;
+        uint32_t id;
+        SimTime delay;
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        void await_resume() {}
+    };
+    struct AcquireAwaiter {
+        ParallelEngine *sim;
+        uint16_t core_id;
+        Process *process;
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> h);
+        void await_resume() {}
+    };
+    struct RunAwaiter {
+        ParallelEngine *sim;
+        uint16_t core_id;
+        Process *process;
+        uint32_t ms;
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        uint32_t await_resume() { return sim->core[core_id].result_ms; }
+    };
+    struct PreemptAwaiter {
+        ParallelEngine *sim;
+        uint16_t core_id;
+        Process *process;
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        void await_resume() {}
+    };
+    struct PlaceAwaiter {
+        ParallelEngine *sim;
+        uint16_t core_id;
+        uint32_t id;
+        uint16_t target;
+        bool await_ready() { return target == core_id; }
+        void await_suspend(std::coroutine_handle<> h);
+        uint16_t await_resume() { return target; }
+    };
+
+    ParallelEngine(uint16_t cores, ScheduleAlgorithm algorithm, uint32_t context_switch, uint32_t time_slice,
+                   uint16_t threads, SimTime migration_latency, uint64_t seed);
+
+    // awaitables used by process lifecycles; all act on the given core's partition
+    DelayAwaiter Delay(uint16_t core_id, uint32_t id, SimTime us);
+    AcquireAwaiter Acquire(uint16_t core_id, Process *p);
+    RunAwaiter RunOn(uint16_t core_id, Process *p, uint32_t ms);
+    PreemptAwaiter Preempt(uint16_t core_id, Process *p);
+    PlaceAwaiter Place(uint16_t core_id, uint32_t id, uint32_t visit);
+    void Release(uint16_t core_id, bool context_switch);
+    void Complete(uint16_t core_id);
+
+    uint16_t HomeCore(uint32_t id);
+    void Spawn(Process *p, uint32_t id);
+    void EnableDecisionLog();
+    void SetAging(uint32_t interval_ms);
+    void WriteDecisions(DecisionLog *log);
+    void Run();
+
+    SimTime Now(uint16_t core_id);
+    SimTime Now();
+    ScheduleAlgorithm GetAlgorithm();
+    uint32_t GetTimeSlice();
+    uint16_t GetCores();
+    uint16_t GetThreads();
+    uint64_t GetWindows();
+    uint64_t GetEventsProcessed();
+    uint64_t GetCoreBusy(uint16_t core_id);
+    uint32_t GetCoreContextSwitches(uint16_t core_id);
+    uint32_t GetCoreMigrations(uint16_t core_id);
+    uint32_t GetCorePeakReady(uint16_t core_id);
+    const std::vector<SimTime>& GetCompletions();
+};
+
+SimTask PartitionedLifecycle(ParallelEngine *sim, Process *p, uint32_t id);
+
+#endif // __PARALLELENGINE_H_
@@ -4,35 +4,75 @@
 #include "configreader.h"
 #include "chrono"
 
+// Fixed-size image of a process used by checkpoints. Wall-clock time points
+// are stored as milliseconds before the moment the snapshot was taken.
+typedef struct ProcessSnapshot {
+    uint32_t pid;
+    uint32_t start_time;
+    uint16_t num_bursts;
+    uint16_t current_burst;
+    uint32_t burst_elapsed;
+    uint32_t since_start;
+    uint32_t since_burst_start;
+    uint32_t since_last_run;
+    uint32_t since_ready;
+    uint32_t migrations;
+    uint32_t preemptions;
+    int32_t migration_time;
+    int32_t response_time;
+    int32_t turn_time;
+    int32_t wait_time;
+    int32_t cpu_time;
+    int32_t remain_time;
+    int16_t core;
+    int16_t last_core;
+    uint8_t priority;
+    uint8_t state;
+} ProcessSnapshot;
+
 class Process {
 public:
-    enum State : uint8_t {NotStarted, Ready, Running, IO, Terminated};
+    enum State : uint8_t {NotStarted, Ready, Running, IO, Terminated, Deferred, Rejected};
 
 private:
-    uint16_t pid;
+    uint32_t pid;
     uint32_t start_time;
     uint16_t num_bursts;
     uint16_t current_burst;
-    uint32_t *burst_times;
+    const uint32_t *burst_times;
     std::chrono::high_resolution_clock::time_point process_start_time;
     std::chrono::high_resolution_clock::time_point burst_start_time;
     std::chrono::high_resolution_clock::time_point ready_queue_entry_time;
+    std::chrono::high_resolution_clock::time_point ready_since;
     uint32_t burst_elapsed;
     uint8_t priority;
+    uint8_t effective_priority;
     State state;
-    int8_t core;
+    int16_t core;
+    int16_t last_core;
+    std::chrono::high_resolution_clock::time_point last_run_end;
+    uint32_t migrations;
+    int32_t migration_time;
+    uint32_t preemptions;
+    int32_t response_time;
     int32_t turn_time;
     int32_t wait_time;
     int32_t cpu_time;
     int32_t remain_time;
 
 public:
-    Process(ProcessDetails details);
-    ~Process();
+    // burst_times / bursts are borrowed, see ProcessTable
+    Process(const ProcessDetails &details);
+    Process(const ProcessSnapshot &snapshot, const uint32_t *bursts,
+            std::chrono::high_resolution_clock::time_point now);
+
+    void Snapshot(ProcessSnapshot *snapshot, std::chrono::high_resolution_clock::time_point now);
 
-    uint16_t GetPid();
+    uint32_t GetPid();
     uint32_t GetStartTime();
     uint8_t GetPriority();
+    uint8_t GetEffectivePriority();
+    void SetEffectivePriority(uint8_t value);
     State GetState();
     void SetState(Process::State input);
     uint32_t GetBurstTime();
@@ -42,14 +82,28 @@ public:
     void SetBurstStartTime();
     std::chrono::high_resolution_clock::time_point GetReadyQueueEntryTime();
     void SetReadyQueueEntryTime(std::chrono::high_resolution_clock::time_point now);
+    std::chrono::high_resolution_clock::time_point GetReadySince();
+    void SetReadySince(std::chrono::high_resolution_clock::time_point now);
     void UpdateCurrentBurst();
-    int8_t GetCpuCore();
-    void SetCpuCore(int8_t Core);
+    int16_t GetCpuCore();
+    void SetCpuCore(int16_t Core);
+    int16_t GetLastCore();
+    std::chrono::high_resolution_clock::time_point GetLastRunEnd();
+    uint32_t GetMigrations();
+    double GetMigrationTime();
+    void CalcMigrationTime(int32_t penalty_us);
+    uint32_t GetPreemptions();
+    void UpdatePreemptions();
+    int32_t GetResponseMs();
+    void CalcResponseTime(int32_t time_elapsed);
     double GetTurnaroundTime();
+    int32_t GetTurnaroundMs();
     void CalcTurnaroundTime(int32_t time_elapsed);
     double GetWaitTime();
+    int32_t GetWaitMs();
     void CalcWaitTime(int32_t time_elapsed);
     double GetCpuTime();
+    int32_t GetCpuMs();
     void CalcCpuTime(int32_t time_elapsed);
     double GetRemainingTime();
     void SetRemainingTime(int32_t time_elapsed);
@@ -57,4 +111,24 @@ public:
     void SetBurstElapsed(uint32_t time_elapsed);
 };
 
+// Every process of a run, constructed in place in one allocation, together
+// with a reference to the burst pool their burst times point into. The
+// pointer list is what the schedulers pass around; it stays valid until the
+// table is rebuilt or destroyed.
+class ProcessTable {
+private:
+    BurstPool bursts;
+    std::vector<Process> storage;
+    std::vector<Process*> processes;
+
+    void Index();
+
+public:
+    void Create(const SchedulerConfig &config);
+    void Restore(const std::vector<ProcessSnapshot> &snapshots, const BurstPool &bursts,
+                 std::chrono::high_resolution_clock::time_point now);
+    std::vector<Process*>& GetProcesses();
+    const BurstPool& GetBursts();
+};
+
 #endif // __PROCESS_H_
@@ -0,0 +1,49 @@
+#ifndef __PROFILER_H_
+#define __PROFILER_H_
+
+#include <cstdint>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+
+// Hot-path instrumentation for the scheduler threads. Built only with
+// -DSCHED_PROFILE (make PROFILE=1); otherwise every hook below is an empty
+// inline function and ProfileLock/ProfileUnlock are plain lock()/unlock().
+//
+// Each scheduling thread owns slot core_id and the main thread owns slot
+// `cores`, so recording never shares a cache line or needs atomics.
+
+#ifdef SCHED_PROFILE
+
+#define PROFILE_BUCKETS 40
+
+typedef struct Histogram {
+    uint64_t buckets[PROFILE_BUCKETS];
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} Histogram;
+
+void ProfilerInit(uint16_t cores);
+void ProfileLock(std::mutex *mutex, uint16_t slot);
+void ProfileUnlock(std::mutex *mutex, uint16_t slot);
+void ProfileIdleSpin(uint16_t slot);
+void ProfileDispatch(uint16_t slot, std::chrono::high_resolution_clock::time_point ready_since);
+void ProfileScan(std::chrono::high_resolution_clock::time_point scan_start);
+void ProfilerPrint(std::ostream &out);
+void ProfilerDelete();
+
+#else
+
+inline void ProfilerInit(uint16_t) {}
+inline void ProfileLock(std::mutex *mutex, uint16_t) { mutex->lock(); }
+inline void ProfileUnlock(std::mutex *mutex, uint16_t) { mutex->unlock(); }
+inline void ProfileIdleSpin(uint16_t) {}
+inline void ProfileDispatch(uint16_t, std::chrono::high_resolution_clock::time_point) {}
+inline void ProfileScan(std::chrono::high_resolution_clock::time_point) {}
+inline void ProfilerPrint(std::ostream &) {}
+inline void ProfilerDelete() {}
+
+#endif // SCHED_PROFILE
+
+#endif // __PROFILER_H_
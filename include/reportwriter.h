@@ -0,0 +1,67 @@
+#ifndef __REPORTWRITER_H_
+#define __REPORTWRITER_H_
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "process.h"
+#include "statistics.h"
+
+// Machine-readable end-of-run report (--output csv|json). Rows are formatted
+// straight into one preallocated buffer, with integer and fixed-point
+// conversion done by hand, and handed to fwrite whenever it fills, so writing
+// a million rows does no per-value allocation.
+//
+// CSV is the per-process table, a blank line, then a one-row summary table;
+// with core speeds set, a blank line and a speed,cores,utilization table
+// follow. Rejected processes never ran and only appear in the summary count.
+// JSON is {"processes": [...], "summary": {...}}, the summary ending with a
+// core_types array (empty without core speeds). Times are in seconds.
+
+typedef struct ReportSummary {
+    double elapsed_time;
+    double cpu_utilization;
+    double throughput_first_half;
+    double throughput_second_half;
+    double throughput;
+    double avg_turnaround;
+    double avg_wait;
+    double avg_response;
+    uint64_t context_switches;
+    uint64_t deferred;
+    uint64_t rejected;
+    uint64_t peak_ready;
+    std::vector<CoreTypeGroup> core_types;
+} ReportSummary;
+
+class ReportWriter {
+public:
+    enum Format : uint8_t {CSV, JSON};
+
+private:
+    FILE *out;
+    char *buffer;
+    size_t capacity;
+    size_t used;
+
+    void Reserve(size_t n);
+
+public:
+    ReportWriter(FILE *out, size_t capacity);
+    ~ReportWriter();
+
+    void PutChar(char c);
+    void PutString(const char *s);
+    void PutUInt(uint64_t value);
+    void PutInt(int64_t value);
+    void PutMillis(int64_t ms);
+    void PutFixed(double value, int decimals);
+    void Flush();
+};
+
+bool ParseReportFormat(const char *name, ReportWriter::Format *format);
+void WriteReport(FILE *out, ReportWriter::Format format, const std::vector<Process*> &processes,
+                 const ReportSummary &summary);
+
+#endif // __REPORTWRITER_H_
@@ -0,0 +1,65 @@
+#ifndef __SHMMETRICS_H_
+#define __SHMMETRICS_H_
+
+#include <cstdint>
+#include <atomic>
+
+#define SHM_METRICS_MAGIC 0x544d534f
+#define SHM_METRICS_VERSION 1
+#define SHM_METRICS_MAX_CORES 256
+
+// Payloads are plain data so readers can copy them out between two reads of
+// the owning sequence counter. An odd sequence means a write is in progress.
+typedef struct ShmCoreData {
+    int32_t pid;
+    uint32_t context_switches;
+    uint64_t busy_us;
+    uint64_t idle_us;
+} ShmCoreData;
+
+typedef struct ShmSummaryData {
+    uint32_t elapsed_ms;
+    uint32_t ready_queue_len;
+    uint32_t completed;
+    uint32_t total;
+    uint32_t finished;
+    double turn_p50;
+    double turn_p90;
+    double turn_p99;
+    double wait_p50;
+    double wait_p90;
+    double wait_p99;
+} ShmSummaryData;
+
+// Each core slot has exactly one writer (its scheduling thread), so updates
+// never retry or block: two counter stores around a handful of field stores.
+typedef struct alignas(64) ShmCoreSlot {
+    std::atomic<uint32_t> seq;
+    ShmCoreData data;
+} ShmCoreSlot;
+
+typedef struct alignas(64) ShmSummarySlot {
+    std::atomic<uint32_t> seq;
+    ShmSummaryData data;
+} ShmSummarySlot;
+
+typedef struct ShmMetrics {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t cores;
+    ShmSummarySlot summary;
+    ShmCoreSlot core[SHM_METRICS_MAX_CORES];
+} ShmMetrics;
+
+ShmMetrics* ShmMetricsCreate(const char *name, uint16_t cores);
+ShmMetrics* ShmMetricsOpen(const char *name);
+void ShmMetricsClose(ShmMetrics *metrics);
+void ShmMetricsUnlink(const char *name);
+
+void ShmPublishCore(ShmMetrics *metrics, uint16_t core_id, const ShmCoreData &data);
+void ShmPublishSummary(ShmMetrics *metrics, const ShmSummaryData &data);
+void ShmReadCore(ShmMetrics *metrics, uint16_t core_id, ShmCoreData *data);
+void ShmReadSummary(ShmMetrics *metrics, ShmSummaryData *data);
+uint64_t ShmHeartbeat(ShmMetrics *metrics);
+
+#endif // __SHMMETRICS_H_
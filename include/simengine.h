@@ -0,0 +1,211 @@
+#ifndef __SIMENGINE_H_
+#define __SIMENGINE_H_
+
+#include <coroutine>
+#include <exception>
+#include <queue>
+#include <deque>
+#include <vector>
+#include "configreader.h"
+#include "process.h"
+#include "decisionlog.h"
+#include "aging.h"
+
+// Discrete-event engine (C++20). Every simulated core is plain data and every
+// process lifecycle is a coroutine resumed by a single-threaded event loop,
+// so runs are deterministic and not limited by host threads.
+//
+// Time is kept in microseconds. Bursts and time slices are milliseconds, as in
+// the threaded engine, and context_switch is microseconds to match its
+// usleep(context_switch).
+
+typedef uint64_t SimTime;
+
+// Coroutine return type: starts eagerly and frees its frame when it finishes.
+struct SimTask {
+    struct promise_type {
+        SimTask get_return_object() { return SimTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+class SimEngine {
+public:
+    enum EventKind : uint8_t {Resume, RunEnd, SwitchDone};
+
+private:
+    typedef struct SimEvent {
+        SimTime time;
+        uint64_t seq;
+        std::coroutine_handle<> handle;
+        uint32_t gen;
+        uint16_t core;
+        EventKind kind;
+    } SimEvent;
+
+    typedef struct ReadyEntry {
+        double key;
+        uint64_t seq;
+        SimTime since;
+        Process *process;
+        std::coroutine_handle<> handle;
+        uint16_t *assigned;
+    } ReadyEntry;
+
+    typedef struct SimCore {
+        Process *running;
+        std::coroutine_handle<> handle;
+        SimTime run_start;
+        SimTime run_end;
+        uint32_t run_ms;
+        uint32_t result_ms;
+        uint32_t gen;
+        bool preempting;
+        bool has_pending;
+        ReadyEntry pending;
+        uint64_t busy_us;
+        uint32_t context_switches;
+    } SimCore;
+
+    struct EventLater {
+        bool operator()(const SimEvent &a, const SimEvent &b) const
+        {
+            return (a.time != b.time) ? a.time > b.time : a.seq > b.seq;
+        }
+    };
+    struct EntryLater {
+        bool operator()(const ReadyEntry &a, const ReadyEntry &b) const
+        {
+            return (a.key != b.key) ? a.key > b.key : a.seq > b.seq;
+        }
+    };
+    // idle cores by rank (highest first), then lowest id
+    struct IdleLater {
+        const std::vector<double> *rank;
+        bool operator()(uint16_t a, uint16_t b) const
+        {
+            return ((*rank)[a] != (*rank)[b]) ? (*rank)[a] < (*rank)[b] : a > b;
+        }
+    };
+
+    uint16_t cores;
+    ScheduleAlgorithm algorithm;
+    uint32_t context_switch;
+    uint32_t time_slice;
+    SimTime now;
+    uint64_t next_seq;
+    uint64_t events_processed;
+    std::priority_queue<SimEvent, std::vector<SimEvent>, EventLater> events;
+    std::priority_queue<ReadyEntry, std::vector<ReadyEntry>, EntryLater> ready;
+    std::vector<double> idle_rank;
+    std::priority_queue<uint16_t, std::vector<uint16_t>, IdleLater> idle;
+    std::vector<SimCore> core;
+    std::vector<SimTime> completions;
+    DecisionLog *decision_log;
+    SimTime aging_interval;
+    uint32_t max_ready;
+    bool reject;
+    std::deque<std::coroutine_handle<> > backlog;
+    uint32_t deferred;
+    uint32_t rejected;
+    uint32_t admitted;
+    uint32_t peak_ready;
+    std::vector<double> speed;
+    bool speed_scaled;
+    double fastest;
+    Placement placement;
+    uint16_t window;
+    std::vector<ReadyEntry> scan;
+
+    void Schedule(SimTime time, EventKind kind, std::coroutine_handle<> handle, uint16_t core_id, uint32_t gen);
+    void Enqueue(Process *p, std::coroutine_handle<> handle, uint16_t *assigned);
+    void Dispatch(uint16_t core_id);
+    void CheckPreempt(Process *p);
+    void HandleRunEnd(const SimEvent &e);
+    void AdmitBacklog();
+    bool PopForCore(uint16_t core_id, ReadyEntry *entry);
+    SimTime RunTime(uint16_t core_id, uint32_t ms);
+    uint32_t Work(uint16_t core_id, SimTime us);
+
+public:
+    struct DelayAwaiter {
+        SimEngine *sim;
+        SimTime delay;
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        void await_resume() {}
+    };
+    struct AdmitAwaiter {
+        SimEngine *sim;
+        Process *process;
+        bool admitted;
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> h);
+        bool await_resume() { return admitted; }
+    };
+    struct AcquireAwaiter {
+        SimEngine *sim;
+        Process *process;
+        uint16_t assigned;
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> h);
+        uint16_t await_resume() { return assigned; }
+    };
+    struct RunAwaiter {
+        SimEngine *sim;
+        Process *process;
+        uint16_t core_id;
+        uint32_t ms;
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        uint32_t await_resume() { return sim->core[core_id].result_ms; }
+    };
+    struct PreemptAwaiter {
+        SimEngine *sim;
+        Process *process;
+        uint16_t core_id;
+        uint16_t assigned;
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        uint16_t await_resume() { return assigned; }
+    };
+
+    SimEngine(uint16_t cores, ScheduleAlgorithm algorithm, uint32_t context_switch, uint32_t time_slice);
+
+    // awaitables used by process lifecycles
+    AdmitAwaiter Admit(Process *p);
+    DelayAwaiter Delay(SimTime us);
+    AcquireAwaiter Acquire(Process *p);
+    RunAwaiter RunOn(Process *p, uint16_t core_id, uint32_t ms);
+    PreemptAwaiter Preempt(Process *p, uint16_t core_id);
+    void Release(uint16_t core_id, bool context_switch);
+    void Complete();
+
+    void Spawn(Process *p);
+    void SetDecisionLog(DecisionLog *log);
+    void SetAging(uint32_t interval_ms);
+    void SetAdmission(uint32_t max_ready, bool reject);
+    void SetCoreSpeeds(const std::vector<double> &speeds, Placement placement, uint16_t window);
+    void Run();
+
+    SimTime Now();
+    ScheduleAlgorithm GetAlgorithm();
+    uint32_t GetTimeSlice();
+    uint32_t GetSliceWork(uint16_t core_id);
+    double GetCoreSpeed(uint16_t core_id);
+    uint16_t GetCores();
+    uint64_t GetEventsProcessed();
+    uint64_t GetCoreBusy(uint16_t core_id);
+    uint32_t GetCoreContextSwitches(uint16_t core_id);
+    const std::vector<SimTime>& GetCompletions();
+    uint32_t GetDeferred();
+    uint32_t GetRejected();
+    uint32_t GetPeakReady();
+};
+
+SimTask ProcessLifecycle(SimEngine *sim, Process *p);
+
+#endif // __SIMENGINE_H_
@@ -0,0 +1,62 @@
+#ifndef __STATISTICS_H_
+#define __STATISTICS_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "process.h"
+
+// End-of-run aggregation. The process table is read once into contiguous
+// integer columns (milliseconds, as Process stores them); every aggregate is
+// then a straight loop over those arrays that the compiler can vectorise, and
+// the conversion to seconds happens once per result rather than per process.
+
+typedef struct ColumnSummary {
+    uint64_t count;
+    double sum;
+    double mean;
+    double min;
+    double max;
+    double variance;
+    double stddev;
+} ColumnSummary;
+
+typedef struct PriorityGroup {
+    uint8_t priority;
+    uint64_t count;
+    double mean_turn;
+    double mean_wait;
+    double mean_cpu;
+} PriorityGroup;
+
+// Cores sharing a speed factor, fastest type first.
+typedef struct CoreTypeGroup {
+    double speed;
+    uint16_t cores;
+    double utilization;
+} CoreTypeGroup;
+
+class ProcessStatistics {
+private:
+    std::vector<int32_t> turn_ms;
+    std::vector<int32_t> wait_ms;
+    std::vector<int32_t> cpu_ms;
+    std::vector<int32_t> response_ms;
+    std::vector<uint8_t> priority;
+
+public:
+    ProcessStatistics(const std::vector<Process*> &processes);
+
+    size_t GetCount();
+    ColumnSummary GetTurnaroundSummary();
+    ColumnSummary GetWaitSummary();
+    ColumnSummary GetCpuSummary();
+    ColumnSummary GetResponseSummary();
+    std::vector<PriorityGroup> GetPriorityGroups();
+};
+
+ColumnSummary SummarizeColumn(const int32_t *values, size_t n);
+double MeanOf(const double *values, size_t n);
+std::vector<CoreTypeGroup> GroupCoreTypes(const double *speeds, const double *utilization, size_t n);
+
+#endif // __STATISTICS_H_
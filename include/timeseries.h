@@ -0,0 +1,54 @@
+#ifndef __TIMESERIES_H_
+#define __TIMESERIES_H_
+
+#include <cstdio>
+#include <cstdint>
+
+// One fixed-width sampling window. Per-core utilisation lives in a flat array
+// owned by TimeSeries so the ring never allocates after construction.
+typedef struct TimeSample {
+    uint32_t window_start_ms;
+    uint32_t window_end_ms;
+    uint32_t completed;
+    uint32_t ready_queue_len;
+    uint32_t context_switches;
+    double throughput;
+    double context_switch_rate;
+} TimeSample;
+
+class TimeSeries {
+public:
+    enum Format : uint8_t {CSV, JSON};
+
+private:
+    uint32_t capacity;
+    uint16_t cores;
+    uint32_t window_ms;
+    uint32_t head;
+    uint32_t count;
+    uint32_t dropped;
+    TimeSample *samples;
+    double *core_util;
+    uint64_t *prev_busy_us;
+    uint32_t prev_completed;
+    uint32_t prev_context_switches;
+    uint32_t prev_window_end_ms;
+    Format format;
+    FILE *stream;
+
+    void WriteCsvHeader(FILE *out);
+    void WriteSample(FILE *out, uint32_t index, bool first);
+
+public:
+    TimeSeries(uint32_t capacity, uint16_t cores, uint32_t window_ms);
+    ~TimeSeries();
+
+    uint32_t GetWindow();
+    bool WindowElapsed(uint32_t now_ms);
+    void Record(uint32_t now_ms, uint32_t completed, uint32_t ready_queue_len,
+                const uint64_t *busy_us, uint32_t context_switches);
+    void SetStream(FILE *out, Format fmt);
+    void Write(FILE *out, Format fmt);
+};
+
+#endif // __TIMESERIES_H_
@@ -0,0 +1,132 @@
+#include "checkpoint.h"
+#include <cstdio>
+#include <string>
+
+template <typename T>
+static bool WriteVector(FILE *file, const std::vector<T> &values)
+{
+    return values.empty() || fwrite(values.data(), sizeof(T), values.size(), file) == values.size();
+}
+
+template <typename T>
+static bool ReadVector(FILE *file, std::vector<T> *values, size_t count)
+{
+    values->resize(count);
+    return count == 0 || fread(values->data(), sizeof(T), count, file) == count;
+}
+
+// Written to a temporary file and renamed, so an interrupted write never
+// replaces the previous good checkpoint.
+bool WriteCheckpoint(const char *filename, const Checkpoint &checkpoint)
+{
+    std::string tmp = std::string(filename) + ".tmp";
+    FILE *file = fopen(tmp.c_str(), "wb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    bool ok = fwrite(&checkpoint.header, sizeof(CheckpointHeader), 1, file) == 1 &&
+              WriteVector(file, checkpoint.processes) &&
+              WriteVector(file, *checkpoint.bursts) &&
+              WriteVector(file, checkpoint.ready_queue) &&
+              WriteVector(file, checkpoint.core_busy_us) &&
+              WriteVector(file, checkpoint.core_migrations) &&
+              WriteVector(file, checkpoint.core_migration_us) &&
+              WriteVector(file, checkpoint.core_speeds);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), filename) != 0)
+    {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// The vectors must exactly fill the rest of the file; checked before anything
+// is allocated for them, so a corrupt count cannot ask for gigabytes.
+static bool SizeMatches(FILE *file, const CheckpointHeader &h)
+{
+    uint64_t expected = sizeof(CheckpointHeader) +
+                        (uint64_t)h.num_processes * sizeof(ProcessSnapshot) +
+                        (uint64_t)h.num_bursts * sizeof(uint32_t) +
+                        (uint64_t)h.ready_queue_len * sizeof(uint32_t) +
+                        (uint64_t)h.cores * (sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(double));
+    long start = ftell(file);
+    if (start < 0 || fseek(file, 0, SEEK_END) != 0)
+    {
+        return false;
+    }
+    long size = ftell(file);
+    return fseek(file, start, SEEK_SET) == 0 && size >= 0 && (uint64_t)size == expected;
+}
+
+// Everything a resume indexes with: enum values, core ids, burst counts that
+// add up to the pool and ready queue entries inside the process table. Only a
+// finished process may have moved past its last burst.
+static bool ContentsValid(const Checkpoint &checkpoint)
+{
+    const CheckpointHeader &h = checkpoint.header;
+    uint32_t i;
+    uint64_t total = 0;
+    if (h.cores == 0 || h.algorithm > ScheduleAlgorithm::PP || h.admission > AdmissionPolicy::Reject ||
+        h.placement > Placement::Speed || h.ready_queue_len > h.num_processes)
+    {
+        return false;
+    }
+    for (i = 0; i < h.num_processes; i++)
+    {
+        const ProcessSnapshot &s = checkpoint.processes[i];
+        bool finished = (s.state == Process::State::Terminated || s.state == Process::State::Rejected);
+        if (s.state > Process::State::Rejected || s.current_burst > s.num_bursts ||
+            (s.current_burst == s.num_bursts && !finished) ||
+            s.core < -1 || s.core >= h.cores || s.last_core < -1 || s.last_core >= h.cores)
+        {
+            return false;
+        }
+        total += s.num_bursts;
+    }
+    if (total != h.num_bursts)
+    {
+        return false;
+    }
+    for (i = 0; i < h.ready_queue_len; i++)
+    {
+        if (checkpoint.ready_queue[i] >= h.num_processes)
+        {
+            return false;
+        }
+    }
+    for (i = 0; i < h.cores && h.speed_scaled; i++)
+    {
+        if (!(checkpoint.core_speeds[i] > 0.0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// False for a missing, truncated or corrupt file as well as a failed read.
+bool ReadCheckpoint(const char *filename, Checkpoint *checkpoint)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    CheckpointHeader *h = &checkpoint->header;
+    std::shared_ptr<std::vector<uint32_t> > bursts = std::make_shared<std::vector<uint32_t> >();
+    checkpoint->bursts = bursts;
+    bool ok = fread(h, sizeof(CheckpointHeader), 1, file) == 1 &&
+              h->magic == CHECKPOINT_MAGIC && h->version == CHECKPOINT_VERSION &&
+              SizeMatches(file, *h) &&
+              ReadVector(file, &checkpoint->processes, h->num_processes) &&
+              ReadVector(file, bursts.get(), h->num_bursts) &&
+              ReadVector(file, &checkpoint->ready_queue, h->ready_queue_len) &&
+              ReadVector(file, &checkpoint->core_busy_us, h->cores) &&
+              ReadVector(file, &checkpoint->core_migrations, h->cores) &&
+              ReadVector(file, &checkpoint->core_migration_us, h->cores) &&
+              ReadVector(file, &checkpoint->core_speeds, h->cores);
+    fclose(file);
+    return ok && ContentsValid(*checkpoint);
+}
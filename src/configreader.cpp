@@ -2,41 +2,55 @@
 #include "algorithm"
 #include "stdlib.h"
 
-void ReadConfigFile(const char *filename, SchedulerConfig **config)
+std::unique_ptr<SchedulerConfig> ReadConfigFile(const char *filename)
 {
     std::string line;
     std::ifstream file(filename);
-    *config = (SchedulerConfig*)malloc(sizeof(SchedulerConfig));
+    std::unique_ptr<SchedulerConfig> result(new SchedulerConfig());
+    SchedulerConfig *config = result.get();
     
     // read line 1 --> number of cpu cores
     std::getline(file, line);
-    (*config)->cores = std::stoi(line);
+    config->cores = std::stoi(line);
 
     // read line 2 --> scheduling algorithm
     std::getline(file, line);
-    if (line == "RR")        (*config)->algorithm = ScheduleAlgorithm::RR;
-    else if (line == "FCFS") (*config)->algorithm = ScheduleAlgorithm::FCFS;
-    else if (line == "SJF")  (*config)->algorithm = ScheduleAlgorithm::SJF;
-    else if (line == "PP")   (*config)->algorithm = ScheduleAlgorithm::PP;
+    if (line == "RR")        config->algorithm = ScheduleAlgorithm::RR;
+    else if (line == "FCFS") config->algorithm = ScheduleAlgorithm::FCFS;
+    else if (line == "SJF")  config->algorithm = ScheduleAlgorithm::SJF;
+    else if (line == "PP")   config->algorithm = ScheduleAlgorithm::PP;
 
     // read line 3 --> context switch time (ms)
     std::getline(file, line);
-    (*config)->context_switch = std::stoi(line);
+    config->context_switch = std::stoi(line);
 
     // read line 4 --> time slice (ms)
     std::getline(file, line);
-    (*config)->time_slice = std::stoi(line);
+    config->time_slice = std::stoi(line);
 
     // read line 5 --> number of processes
     std::getline(file, line);
-    (*config)->num_processes = std::stoi(line);
-    (*config)->processes = new ProcessDetails[(*config)->num_processes];
+    config->num_processes = std::stoi(line);
+    config->processes.resize(config->num_processes);
 
-    // read lines 6 - N --> details for each process
+    // first pass over lines 6 - N counts the bursts ('|' separated, only in
+    // column 3) so the pool is allocated once at its final size
     int i, j;
+    size_t total_bursts = 0;
+    std::streampos process_lines = file.tellg();
+    for (i = 0; i < config->num_processes && std::getline(file, line); i++)
+    {
+        total_bursts += std::count(line.begin(), line.end(), '|') + 1;
+    }
+    file.clear();
+    file.seekg(process_lines);
+    std::shared_ptr<std::vector<uint32_t> > bursts = std::make_shared<std::vector<uint32_t> >();
+    bursts->reserve(total_bursts);
+
+    // read lines 6 - N --> details for each process
     std::string item1, item2;
     std::stringstream ss1, ss2;
-    for (i = 0; i < (*config)->num_processes; i++)
+    for (i = 0; i < config->num_processes; i++)
     {
         std::getline(file, line);
         ss1.clear();
@@ -44,45 +58,127 @@ void ReadConfigFile(const char *filename, SchedulerConfig **config)
 
         // column 1 --> pid
         std::getline(ss1, item1, ',');
-        (*config)->processes[i].pid = std::stoi(item1);
+        config->processes[i].pid = std::stoi(item1);
 
         // column 2 --> start time
         std::getline(ss1, item1, ',');
-        (*config)->processes[i].start_time = std::stoi(item1);
+        config->processes[i].start_time = std::stoi(item1);
 
         // column 3 --> cpu and i/o burst times
         std::getline(ss1, item1, ',');
-        (*config)->processes[i].num_bursts = std::count(item1.begin(), item1.end(), '|') + 1;
-        (*config)->processes[i].burst_times = new uint32_t[(*config)->processes[i].num_bursts];
+        config->processes[i].num_bursts = std::count(item1.begin(), item1.end(), '|') + 1;
         ss2.clear();
         ss2.str(item1);
-        for (j = 0; j < (*config)->processes[i].num_bursts; j++)
+        for (j = 0; j < config->processes[i].num_bursts; j++)
         {
             std::getline(ss2, item2, '|');
-            (*config)->processes[i].burst_times[j] = std::stoi(item2);
+            bursts->push_back(std::stoi(item2));
         }
 
         // column 4 --> priority
         std::getline(ss1, item1, ',');
-        if ((*config)->algorithm == ScheduleAlgorithm::PP)
+        if (config->algorithm == ScheduleAlgorithm::PP)
         {
-            (*config)->processes[i].priority = std::stoi(item1);
+            config->processes[i].priority = std::stoi(item1);
         }
         else
         {
-            (*config)->processes[i].priority = 0;
+            config->processes[i].priority = 0;
         }
     }
-}
 
-void DeleteConfig(SchedulerConfig **config)
-{
-    int i;
-    for (i = 0; i < (*config)->num_processes; i++)
+    // the pool has stopped growing, so pointers into it are now stable
+    const uint32_t *next = bursts->data();
+    for (i = 0; i < config->num_processes; i++)
+    {
+        config->processes[i].burst_times = next;
+        next += config->processes[i].num_bursts;
+    }
+    config->bursts = bursts;
+
+    // optional lines after the processes --> key=value model settings
+    //  migration_penalty: cold-cache cost (us) when a process changes core
+    //  cache_decay: time away (ms) over which that cost decays by a factor e
+    //  affinity_window: ready queue entries a core looks at to keep affinity
+    //  aging_interval: PP only, time ready (ms) that raises priority one level
+    //  migration_latency: partitioned engine, time (us) a process takes to
+    //                     reach another core's queue; defaults to the context
+    //                     switch time with a floor of 1 ms
+    //  max_ready: processes in the system (ready, running or in I/O) above
+    //             which new arrivals are not admitted; bounds the ready queue
+    //  admission: defer (hold arrivals in a backlog) or reject (drop them)
+    //  core_speeds: comma separated speed factor per core (1 = nominal), so a
+    //               0.5 core takes twice as long over the same burst
+    //  placement: any (first come) or speed (slower cores take the shortest
+    //             remaining work among the first affinity_window entries)
+    config->migration_penalty = 0;
+    config->cache_decay = 0;
+    config->affinity_window = 4;
+    config->aging_interval = 0;
+    config->migration_latency = 0;
+    config->max_ready = 0;
+    config->admission = AdmissionPolicy::Defer;
+    config->placement = Placement::Any;
+    while (std::getline(file, line))
+    {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos)
+        {
+            continue;
+        }
+        item1 = line.substr(0, eq);
+        item2 = line.substr(eq + 1);
+        if (item1 == "migration_penalty")    config->migration_penalty = std::stoi(item2);
+        else if (item1 == "cache_decay")     config->cache_decay = std::stoi(item2);
+        else if (item1 == "affinity_window") config->affinity_window = std::stoi(item2);
+        else if (item1 == "aging_interval")  config->aging_interval = std::stoi(item2);
+        else if (item1 == "migration_latency") config->migration_latency = std::stoi(item2);
+        else if (item1 == "max_ready")       config->max_ready = std::stoi(item2);
+        else if (item1 == "admission")
+        {
+            if (item2 == "defer")            config->admission = AdmissionPolicy::Defer;
+            else if (item2 == "reject")      config->admission = AdmissionPolicy::Reject;
+            else
+            {
+                std::cerr << "Error: unknown admission policy " << item2 << std::endl;
+                exit(1);
+            }
+        }
+        else if (item1 == "core_speeds")
+        {
+            config->core_speeds.clear();
+            ss2.clear();
+            ss2.str(item2);
+            while (std::getline(ss2, item1, ','))
+            {
+                config->core_speeds.push_back(std::stod(item1));
+                if (config->core_speeds.back() <= 0.0)
+                {
+                    std::cerr << "Error: core speed must be positive" << std::endl;
+                    exit(1);
+                }
+            }
+        }
+        else if (item1 == "placement")
+        {
+            if (item2 == "any")              config->placement = Placement::Any;
+            else if (item2 == "speed")       config->placement = Placement::Speed;
+            else
+            {
+                std::cerr << "Error: unknown placement " << item2 << std::endl;
+                exit(1);
+            }
+        }
+    }
+    if (config->migration_latency == 0)
+    {
+        config->migration_latency = (config->context_switch > 1000) ? config->context_switch : 1000;
+    }
+    if (!config->core_speeds.empty() && config->core_speeds.size() != config->cores)
     {
-        delete[] (*config)->processes[i].burst_times;
+        std::cerr << "Error: core_speeds lists " << config->core_speeds.size() << " speeds for "
+                  << config->cores << " cores" << std::endl;
+        exit(1);
     }
-    delete[] (*config)->processes;
-    delete *config;
-    *config = NULL;
+    return result;
 }
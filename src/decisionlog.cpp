@@ -0,0 +1,196 @@
+#include "decisionlog.h"
+
+DecisionLog::DecisionLog()
+{
+    file = NULL;
+    mode = Mode::Write;
+    capacity = 4096;
+    buffer = new DecisionRecord[capacity];
+    head = 0;
+    fill = 0;
+    count = 0;
+    diverged = false;
+    divergence = 0;
+    has_expected = false;
+    has_actual = false;
+}
+
+DecisionLog::~DecisionLog()
+{
+    Close();
+    delete[] buffer;
+}
+
+bool DecisionLog::Open(const char *filename, Mode mode, DecisionLogHeader *header)
+{
+    this->mode = mode;
+    file = fopen(filename, (mode == Mode::Write) ? "wb" : "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    if (mode == Mode::Write)
+    {
+        header->magic = DECISIONLOG_MAGIC;
+        header->version = DECISIONLOG_VERSION;
+        return fwrite(header, sizeof(DecisionLogHeader), 1, file) == 1;
+    }
+    return fread(header, sizeof(DecisionLogHeader), 1, file) == 1 &&
+           header->magic == DECISIONLOG_MAGIC && header->version == DECISIONLOG_VERSION;
+}
+
+void DecisionLog::Flush()
+{
+    if (fill > 0)
+    {
+        fwrite(buffer, sizeof(DecisionRecord), fill, file);
+        fill = 0;
+    }
+}
+
+bool DecisionLog::Refill()
+{
+    head = 0;
+    fill = fread(buffer, sizeof(DecisionRecord), capacity, file);
+    return fill > 0;
+}
+
+bool DecisionLog::Next(DecisionRecord *record)
+{
+    if (head == fill && !Refill())
+    {
+        return false;
+    }
+    *record = buffer[head++];
+    return true;
+}
+
+// In Verify mode each record is compared with the next one in the file and
+// the first mismatch is kept; later records are only counted.
+void DecisionLog::Record(uint64_t time_us, uint32_t pid, uint32_t core)
+{
+    DecisionRecord record;
+    record.time_us = time_us;
+    record.pid = pid;
+    record.core = core;
+    if (mode == Mode::Write)
+    {
+        buffer[fill++] = record;
+        if (fill == capacity)
+        {
+            Flush();
+        }
+    }
+    else if (!diverged)
+    {
+        has_actual = true;
+        actual = record;
+        has_expected = Next(&expected);
+        if (!has_expected || expected.time_us != time_us || expected.pid != pid || expected.core != core)
+        {
+            diverged = true;
+            divergence = count;
+        }
+    }
+    count++;
+}
+
+// Verify also fails when the file holds more records than were seen.
+bool DecisionLog::Close()
+{
+    if (file == NULL)
+    {
+        return !diverged;
+    }
+    if (mode == Mode::Write)
+    {
+        Flush();
+    }
+    else if (mode == Mode::Verify && !diverged && Next(&expected))
+    {
+        diverged = true;
+        divergence = count;
+        has_expected = true;
+        has_actual = false;
+    }
+    bool ok = (fclose(file) == 0) && !diverged;
+    file = NULL;
+    return ok;
+}
+
+uint64_t DecisionLog::GetCount()
+{
+    return count;
+}
+
+bool DecisionLog::Diverged()
+{
+    return diverged;
+}
+
+uint64_t DecisionLog::GetDivergence()
+{
+    return divergence;
+}
+
+bool DecisionLog::HasExpected()
+{
+    return has_expected;
+}
+
+bool DecisionLog::HasActual()
+{
+    return has_actual;
+}
+
+DecisionRecord DecisionLog::GetExpected()
+{
+    return expected;
+}
+
+DecisionRecord DecisionLog::GetActual()
+{
+    return actual;
+}
+
+// FNV-1a over everything in the configuration that affects scheduling.
+static void HashBytes(uint64_t *hash, const void *data, size_t len)
+{
+    size_t i;
+    const uint8_t *bytes = (const uint8_t*)data;
+    for (i = 0; i < len; i++)
+    {
+        *hash = (*hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+}
+
+uint64_t HashConfig(SchedulerConfig *config)
+{
+    uint32_t i;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint32_t algorithm = config->algorithm;
+    HashBytes(&hash, &config->cores, sizeof(config->cores));
+    HashBytes(&hash, &algorithm, sizeof(algorithm));
+    HashBytes(&hash, &config->context_switch, sizeof(config->context_switch));
+    HashBytes(&hash, &config->time_slice, sizeof(config->time_slice));
+    HashBytes(&hash, &config->aging_interval, sizeof(config->aging_interval));
+    HashBytes(&hash, &config->migration_latency, sizeof(config->migration_latency));
+    HashBytes(&hash, &config->migration_penalty, sizeof(config->migration_penalty));
+    HashBytes(&hash, &config->cache_decay, sizeof(config->cache_decay));
+    HashBytes(&hash, &config->affinity_window, sizeof(config->affinity_window));
+    HashBytes(&hash, &config->max_ready, sizeof(config->max_ready));
+    HashBytes(&hash, &config->admission, sizeof(config->admission));
+    HashBytes(&hash, config->core_speeds.data(), config->core_speeds.size() * sizeof(double));
+    HashBytes(&hash, &config->placement, sizeof(config->placement));
+    HashBytes(&hash, &config->num_processes, sizeof(config->num_processes));
+    for (i = 0; i < config->num_processes; i++)
+    {
+        ProcessDetails *p = &config->processes[i];
+        HashBytes(&hash, &p->pid, sizeof(p->pid));
+        HashBytes(&hash, &p->start_time, sizeof(p->start_time));
+        HashBytes(&hash, &p->priority, sizeof(p->priority));
+        HashBytes(&hash, &p->num_bursts, sizeof(p->num_bursts));
+        HashBytes(&hash, p->burst_times, p->num_bursts * sizeof(uint32_t));
+    }
+    return hash;
+}
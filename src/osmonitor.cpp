@@ -0,0 +1,98 @@
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <unistd.h>
+#include "shmmetrics.h"
+
+// How long the segment may go without a write before the scheduler is
+// presumed dead
+#define STALE_MS 5000
+
+int PrintMetrics(ShmMetrics *metrics, ShmSummaryData *summary);
+
+int main(int argc, char **argv)
+{
+    // Ensure user entered the shared memory segment name used by osscheduler --shm
+    if (argc < 2)
+    {
+        std::cerr << "Error: must specify shared memory name (e.g. /osscheduler)" << std::endl;
+        exit(1);
+    }
+    uint32_t interval_ms = (argc > 2) ? std::stoi(argv[2]) : 500;
+
+    // Wait for the scheduler to create the segment
+    ShmMetrics *metrics = NULL;
+    while ((metrics = ShmMetricsOpen(argv[1])) == NULL)
+    {
+        usleep(100000);
+    }
+
+    ShmSummaryData summary;
+    int i;
+    int linesPrinted = 0;
+    uint64_t lastBeat = 0;
+    uint32_t stalePolls = 0;
+    uint32_t maxStalePolls = (interval_ms == 0) ? STALE_MS : STALE_MS / interval_ms + 1;
+    do
+    {
+        for (i = 0; i < linesPrinted; i++)
+        {
+            fputs("\033[A\033[2K", stdout);
+        }
+        ShmReadSummary(metrics, &summary);
+        linesPrinted = PrintMetrics(metrics, &summary);
+        fflush(stdout);
+        if (summary.finished)
+        {
+            break;
+        }
+
+        // a scheduler that crashed or was killed never sets finished
+        uint64_t beat = ShmHeartbeat(metrics);
+        stalePolls = (beat == lastBeat) ? stalePolls + 1 : 0;
+        lastBeat = beat;
+        if (stalePolls >= maxStalePolls)
+        {
+            std::cerr << "Error: " << argv[1] << " stopped updating; the scheduler is no longer running" << std::endl;
+            ShmMetricsClose(metrics);
+            exit(1);
+        }
+        usleep(interval_ms * 1000);
+    } while (true);
+
+    ShmMetricsClose(metrics);
+    return 0;
+}
+
+int PrintMetrics(ShmMetrics *metrics, ShmSummaryData *summary)
+{
+    int i;
+    int linesPrinted = 0;
+    ShmCoreData core;
+
+    printf("Elapsed: %.1fs  Completed: %u/%u  Ready queue: %u%s\n", summary->elapsed_ms / 1000.0,
+           summary->completed, summary->total, summary->ready_queue_len, summary->finished ? "  (finished)" : "");
+    printf("Turnaround p50/p90/p99: %.3f / %.3f / %.3f\n", summary->turn_p50, summary->turn_p90, summary->turn_p99);
+    printf("Wait time  p50/p90/p99: %.3f / %.3f / %.3f\n", summary->wait_p50, summary->wait_p90, summary->wait_p99);
+    printf("| Core |   PID |    Busy (s) |    Idle (s) |   Util | Switches |\n");
+    printf("+------+-------+-------------+-------------+--------+----------+\n");
+    linesPrinted += 5;
+    for (i = 0; i < metrics->cores; i++)
+    {
+        ShmReadCore(metrics, i, &core);
+        uint64_t total = core.busy_us + core.idle_us;
+        double util = (total == 0) ? 0.0 : (core.busy_us * 100.0) / total;
+        if (core.pid >= 0)
+        {
+            printf("| %4d | %5d | %11.3f | %11.3f | %5.1f%% | %8u |\n", i, core.pid,
+                   core.busy_us / 1000000.0, core.idle_us / 1000000.0, util, core.context_switches);
+        }
+        else
+        {
+            printf("| %4d |    -- | %11.3f | %11.3f | %5.1f%% | %8u |\n", i,
+                   core.busy_us / 1000000.0, core.idle_us / 1000000.0, util, core.context_switches);
+        }
+        linesPrinted++;
+    }
+    return linesPrinted;
+}
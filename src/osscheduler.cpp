@@ -1,75 +1,380 @@
 #include <iostream>
 #include <string>
+#include <cstring>
 #include <list>
+#include <deque>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
 #include <unistd.h>
 #include "configreader.h"
 #include "process.h"
+#include "timeseries.h"
+#include "shmmetrics.h"
+#include "profiler.h"
+#include "statistics.h"
+#include "checkpoint.h"
+#include "decisionlog.h"
+#include "reportwriter.h"
+#include "aging.h"
 #include "time.h"
 
-void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t context_switch, uint32_t time_slice,
+void ScheduleProcesses(uint16_t core_id, ScheduleAlgorithm algorithm, uint32_t context_switch, uint32_t time_slice,
                        std::list<Process*> *ready_queue, std::mutex *mutex);
-int PrintStatistics(std::vector<Process*> processes, ScheduleAlgorithm algorithm);
+int PrintStatistics(const std::vector<Process*> &processes, ScheduleAlgorithm algorithm);
 void PPInsert(std::list<Process*> *ready_queue, Process* currentProcess);
 void SJFInsert(std::list<Process*> *ready_queue, Process* currentProcess);
-double printTurnTime(std::vector<Process*> processes);
-double printWaitTime(std::vector<Process*> processes);
+void ReadyQueueInsert(ScheduleAlgorithm algorithm, std::list<Process*> *ready_queue, Process* currentProcess);
+void QueueInsert(ScheduleAlgorithm algorithm, std::list<Process*> *ready_queue, Process* currentProcess);
+void AdmitProcess(ScheduleAlgorithm algorithm, std::list<Process*> *ready_queue, std::deque<Process*> *backlog,
+                  Process* currentProcess);
+void AdmitBacklog(ScheduleAlgorithm algorithm, std::list<Process*> *ready_queue, std::deque<Process*> *backlog);
+Process* PickProcess(std::list<Process*> *ready_queue, uint16_t core_id, ScheduleAlgorithm algorithm);
+bool ReplayTurn(std::list<Process*> *ready_queue, uint16_t core_id, Process* currentProcess);
+bool ReplaySliceEnds(std::list<Process*> *ready_queue, std::mutex *mutex, uint16_t core_id, Process* currentProcess);
+int32_t MigrationPenalty(Process* currentProcess, uint16_t core_id);
+void MigrateProcess(Process* currentProcess, uint16_t core_id);
+uint32_t CoreWork(uint16_t core_id, double elapsed_ms, double *carry);
+uint8_t EffectivePriority(Process* currentProcess, std::chrono::high_resolution_clock::time_point now);
+uint64_t EpochMs(std::chrono::high_resolution_clock::time_point t);
+void PublishCoreMetrics(uint16_t core_id, int32_t pid, uint32_t context_switches,
+                        std::chrono::high_resolution_clock::time_point threadstarted);
+void PublishSummaryMetrics(std::vector<Process*> *processes, std::vector<double> *turn_times,
+                           std::vector<double> *wait_times, uint32_t elapsed_ms, uint32_t ready_queue_len,
+                           uint32_t completed, bool finished);
+double Percentile(std::vector<double> *values, double pct);
+void CaptureCheckpoint(Checkpoint *checkpoint, const std::vector<Process*> &processes,
+                       const std::unordered_map<Process*, uint32_t> &index, std::list<Process*> *ready_queue,
+                       std::mutex *mutex, uint16_t cores, std::chrono::high_resolution_clock::time_point now);
 
 //global variables
 bool processesTerminated = false;
-double CPUUtilCore[4];
+double *CPUUtilCore;
+std::atomic<uint64_t> *coreBusyUs;
+std::atomic<uint32_t> contextSwitches(0);
+ShmMetrics *shmMetrics = NULL;
+uint32_t migrationPenalty = 0;
+uint32_t cacheDecay = 0;
+uint16_t affinityWindow = 1;
+uint32_t agingInterval = 0;
+uint32_t maxReady = 0;
+AdmissionPolicy admissionPolicy = AdmissionPolicy::Defer;
+uint32_t deferredCount = 0;
+uint32_t rejectedCount = 0;
+std::atomic<uint32_t> admittedLive(0);
+uint32_t peakReady = 0;
+double *coreSpeed;
+bool speedScaled = false;
+double fastestSpeed = 1.0;
+Placement placement = Placement::Any;
+std::atomic<bool> *coreIdle;
+uint16_t coreCount = 0;
+std::atomic<uint32_t> *coreMigrations;
+std::atomic<uint64_t> *coreMigrationUs;
+DecisionLog *decisionLog = NULL;
+std::vector<DecisionRecord> replayRecords;
+std::vector<Process*> replayProcesses;
+size_t replayNext = 0;
+uint64_t replaySkipped = 0;
+std::atomic<bool> replaying(false);
+const char *replayStop = NULL;
+uint64_t dispatchCount = 0;
+std::chrono::high_resolution_clock::time_point runStart;
 
 int main(int argc, char **argv)
 {
     std::chrono::high_resolution_clock timer;
     
-    // Ensure user entered a command line parameter for configuration file name
-    if (argc < 2)
+    // Configuration file name plus optional flags; a resumed run takes its
+    // configuration from the checkpoint instead
+    int i;
+    const char *config_file = NULL;
+    const char *checkpoint_file = NULL;
+    const char *resume_file = NULL;
+    uint32_t checkpoint_interval = 10000;
+    const char *decision_log_file = NULL;
+    const char *replay_file = NULL;
+    const char *output_file = NULL;
+    bool output = false;
+    ReportWriter::Format output_format = ReportWriter::Format::CSV;
+    const char *timeseries_file = NULL;
+    bool timeseries_stream = false;
+    const char *shm_name = NULL;
+    uint32_t timeseries_window = 1000;
+    uint32_t timeseries_capacity = 4096;
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            checkpoint_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint-interval") == 0 && i + 1 < argc)
+        {
+            checkpoint_interval = std::stoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            if (!ParseReportFormat(argv[++i], &output_format))
+            {
+                std::cerr << "Error: unknown output format " << argv[i] << std::endl;
+                exit(1);
+            }
+            output = true;
+        }
+        else if (strcmp(argv[i], "--output-file") == 0 && i + 1 < argc)
+        {
+            output_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--decision-log") == 0 && i + 1 < argc)
+        {
+            decision_log_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replay_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc)
+        {
+            resume_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--timeseries") == 0 && i + 1 < argc)
+        {
+            timeseries_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--timeseries-window") == 0 && i + 1 < argc)
+        {
+            timeseries_window = std::stoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--timeseries-capacity") == 0 && i + 1 < argc)
+        {
+            timeseries_capacity = std::stoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--timeseries-stream") == 0)
+        {
+            timeseries_stream = true;
+        }
+        else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc)
+        {
+            shm_name = argv[++i];
+        }
+        else if (strncmp(argv[i], "--", 2) != 0 && config_file == NULL)
+        {
+            config_file = argv[i];
+        }
+        else
+        {
+            std::cerr << "Error: unknown option " << argv[i] << std::endl;
+            exit(1);
+        }
+    }
+
+    // Ensure user entered a configuration file name or a checkpoint to resume
+    if (config_file == NULL && resume_file == NULL)
     {
         std::cerr << "Error: must specify configuration file" << std::endl;
         exit(1);
     }
+    // Machine-readable output on stdout replaces the live table and text report
+    bool quiet = output && output_file == NULL;
+    FILE *output_out = stdout;
+    if (output_file != NULL)
+    {
+        output_out = fopen(output_file, "w");
+        if (output_out == NULL)
+        {
+            std::cerr << "Error: cannot open " << output_file << std::endl;
+            exit(1);
+        }
+    }
+    if (resume_file != NULL && (decision_log_file != NULL || replay_file != NULL))
+    {
+        std::cerr << "Error: --decision-log and --replay cannot be used with --resume" << std::endl;
+        exit(1);
+    }
 
-    // Read configuration file for scheduling simulation
-    SchedulerConfig *config;
-    ReadConfigFile(argv[1], &config);
-
-    // Store configuration parameters and create processes 
-    int i;
-    uint8_t cores = config->cores;
-    ScheduleAlgorithm algorithm = config->algorithm;
-    uint32_t context_switch = config->context_switch;
-    uint32_t time_slice = config->time_slice;
-    std::vector<Process*> processes;
+    uint16_t cores;
+    ScheduleAlgorithm algorithm;
+    uint32_t context_switch;
+    uint32_t time_slice;
+    ProcessTable table;
+    std::vector<Process*> &processes = table.GetProcesses();
     std::list<Process*> ready_queue;
-    for (i = 0; i < config->num_processes; i++)
+    std::deque<Process*> backlog;
+    std::vector<double> core_speeds;
+    Checkpoint checkpoint;
+    if (resume_file != NULL)
     {
-        Process *p = new Process(config->processes[i]);
-        processes.push_back(p);
-        if (p->GetState() == Process::State::Ready)
+        // Rebuild the process table, ready queue order and clock from the snapshot
+        if (!ReadCheckpoint(resume_file, &checkpoint))
+        {
+            std::cerr << "Error: cannot read checkpoint " << resume_file << " (missing, truncated or corrupt)" << std::endl;
+            exit(1);
+        }
+        cores = checkpoint.header.cores;
+        algorithm = (ScheduleAlgorithm)checkpoint.header.algorithm;
+        context_switch = checkpoint.header.context_switch;
+        time_slice = checkpoint.header.time_slice;
+        migrationPenalty = checkpoint.header.migration_penalty;
+        cacheDecay = checkpoint.header.cache_decay;
+        affinityWindow = checkpoint.header.affinity_window;
+        agingInterval = checkpoint.header.aging_interval;
+        maxReady = checkpoint.header.max_ready;
+        admissionPolicy = (AdmissionPolicy)checkpoint.header.admission;
+        deferredCount = checkpoint.header.deferred_count;
+        peakReady = checkpoint.header.peak_ready;
+        placement = (Placement)checkpoint.header.placement;
+        if (checkpoint.header.speed_scaled)
         {
-            processes[i]->SetReadyQueueEntryTime(timer.now());
-            if(algorithm == ScheduleAlgorithm::SJF)
+            core_speeds = checkpoint.core_speeds;
+        }
+        std::chrono::high_resolution_clock::time_point now = timer.now();
+        table.Restore(checkpoint.processes, checkpoint.bursts, now);
+        // processes that were on a core go back to the ready queue ahead of
+        // the queued ones; anything caught between the two is appended
+        std::vector<bool> queued(processes.size(), false);
+        for (i = 0; i < checkpoint.header.ready_queue_len; i++)
+        {
+            uint32_t idx = checkpoint.ready_queue[i];
+            if (idx < processes.size() && !queued[idx])
             {
-                SJFInsert(&ready_queue, p);
+                queued[idx] = true;
             }
-            else if(algorithm == ScheduleAlgorithm::PP)
+        }
+        for (i = 0; i < processes.size(); i++)
+        {
+            if (processes[i]->GetState() == Process::State::Running)
             {
-                PPInsert(&ready_queue, p);
+                processes[i]->SetCpuCore(-1);
+                processes[i]->SetState(Process::State::Ready);
+                if (!queued[i])
+                {
+                    queued[i] = true;
+                    checkpoint.ready_queue.push_back(i);
+                }
             }
-            else
+            else if (processes[i]->GetState() == Process::State::Ready && !queued[i])
+            {
+                queued[i] = true;
+                checkpoint.ready_queue.push_back(i);
+            }
+            if (processes[i]->GetState() == Process::State::Ready || processes[i]->GetState() == Process::State::IO)
+            {
+                admittedLive++;
+            }
+            else if (processes[i]->GetState() == Process::State::Deferred)
+            {
+                backlog.push_back(processes[i]);
+            }
+            else if (processes[i]->GetState() == Process::State::Rejected)
+            {
+                rejectedCount++;
+            }
+        }
+        for (i = 0; i < checkpoint.ready_queue.size(); i++)
+        {
+            uint32_t idx = checkpoint.ready_queue[i];
+            if (idx < processes.size() && queued[idx] && processes[idx]->GetState() == Process::State::Ready)
+            {
+                queued[idx] = false;
+                QueueInsert(algorithm, &ready_queue, processes[idx]);
+            }
+        }
+        contextSwitches = checkpoint.header.context_switches;
+    }
+    else
+    {
+        // Read configuration file for scheduling simulation
+        std::unique_ptr<SchedulerConfig> config = ReadConfigFile(config_file);
+
+        // Store configuration parameters and create processes 
+        cores = config->cores;
+        algorithm = config->algorithm;
+        context_switch = config->context_switch;
+        time_slice = config->time_slice;
+        migrationPenalty = config->migration_penalty;
+        cacheDecay = config->cache_decay;
+        affinityWindow = config->affinity_window;
+        agingInterval = config->aging_interval;
+        maxReady = config->max_ready;
+        admissionPolicy = config->admission;
+        core_speeds = config->core_speeds;
+        placement = config->placement;
+        // Dispatch log in ossim's format, to compare runs with ossim --diff-log
+        if (decision_log_file != NULL)
+        {
+            DecisionLogHeader header;
+            header.cores = cores;
+            header.algorithm = algorithm;
+            header.engine = DecisionLog::Engine::Threaded;
+            header.threads = cores;
+            header.reserved = 0;
+            header.seed = 0;
+            header.lookahead = 0;
+            header.config_hash = HashConfig(config.get());
+            decisionLog = new DecisionLog();
+            if (!decisionLog->Open(decision_log_file, DecisionLog::Mode::Write, &header))
+            {
+                std::cerr << "Error: cannot create decision log " << decision_log_file << std::endl;
+                exit(1);
+            }
+        }
+        table.Create(*config);
+        // A replay dispatches in the order of a log recorded by --decision-log
+        // (see ReplayTurn); each record is resolved to its process up front
+        if (replay_file != NULL)
+        {
+            DecisionLog replay_log;
+            DecisionLogHeader header;
+            DecisionRecord record;
+            std::unordered_map<uint32_t, Process*> by_pid;
+            if (!replay_log.Open(replay_file, DecisionLog::Mode::Read, &header))
+            {
+                std::cerr << "Error: cannot read decision log " << replay_file << " (missing, truncated or from another version)" << std::endl;
+                exit(1);
+            }
+            if (header.engine != DecisionLog::Engine::Threaded)
             {
-                ready_queue.push_back(p);
-            }         
+                std::cerr << "Error: " << replay_file << " was recorded by ossim; replay it with ossim --replay" << std::endl;
+                exit(1);
+            }
+            if (header.config_hash != HashConfig(config.get()))
+            {
+                std::cerr << "Error: " << replay_file << " was recorded with a different configuration" << std::endl;
+                exit(1);
+            }
+            for (i = 0; i < processes.size(); i++)
+            {
+                by_pid[processes[i]->GetPid()] = processes[i];
+            }
+            while (replay_log.Next(&record))
+            {
+                if (record.core >= cores || by_pid.count(record.pid) == 0)
+                {
+                    std::cerr << "Error: " << replay_file << " names a process or core not in the configuration" << std::endl;
+                    exit(1);
+                }
+                replayRecords.push_back(record);
+                replayProcesses.push_back(by_pid[record.pid]);
+            }
+            replay_log.Close();
+            replaying = !replayRecords.empty();
+        }
+        for (i = 0; i < processes.size(); i++)
+        {
+            if (processes[i]->GetState() == Process::State::Ready)
+            {
+                AdmitProcess(algorithm, &ready_queue, &backlog, processes[i]);
+            }
         }
+        // The configuration is freed here; the burst pool lives on in the table
     }
-    // Free configuration data from memory
-    DeleteConfig(&config);
 
     //PrintStatistics(processes, algorithm);
-    int linesPrinted = PrintStatistics(processes, algorithm);
+    int linesPrinted = quiet ? 0 : PrintStatistics(processes, algorithm);
     //start timer
     
     std::chrono::high_resolution_clock::time_point start_time;
@@ -82,9 +387,113 @@ int main(int argc, char **argv)
     double time2ndHalf = 0.0;
     int flag = 0;
     
+    // Per-core counters shared with the scheduling threads
+    CPUUtilCore = new double[cores];
+    coreBusyUs = new std::atomic<uint64_t>[cores]();
+    coreIdle = new std::atomic<bool>[cores]();
+    coreCount = cores;
+    coreMigrations = new std::atomic<uint32_t>[cores]();
+    coreMigrationUs = new std::atomic<uint64_t>[cores]();
+    coreSpeed = new double[cores];
+    speedScaled = !core_speeds.empty();
+    for (i = 0; i < cores; i++)
+    {
+        coreSpeed[i] = speedScaled ? core_speeds[i] : 1.0;
+        fastestSpeed = (i == 0 || coreSpeed[i] > fastestSpeed) ? coreSpeed[i] : fastestSpeed;
+    }
+    uint64_t *busy_snapshot = new uint64_t[cores];
+    if (resume_file != NULL)
+    {
+        for (i = 0; i < cores; i++)
+        {
+            coreBusyUs[i] = checkpoint.core_busy_us[i];
+            coreMigrations[i] = checkpoint.core_migrations[i];
+            coreMigrationUs[i] = checkpoint.core_migration_us[i];
+        }
+        flag = checkpoint.header.half_flag;
+        timeHalf = checkpoint.header.time_half;
+        throughputFirstHalf = checkpoint.header.throughput_first_half;
+    }
+
+    // Periodic checkpoints are serialised on a writer thread so the scan loop
+    // only holds the ready queue lock long enough to copy its order
+    std::unordered_map<Process*, uint32_t> checkpoint_index;
+    std::thread checkpoint_writer;
+    std::chrono::high_resolution_clock::time_point last_checkpoint;
+    if (checkpoint_file != NULL)
+    {
+        checkpoint.header.magic = CHECKPOINT_MAGIC;
+        checkpoint.header.version = CHECKPOINT_VERSION;
+        checkpoint.header.cores = cores;
+        checkpoint.header.algorithm = (uint8_t)algorithm;
+        checkpoint.header.context_switch = context_switch;
+        checkpoint.header.time_slice = time_slice;
+        checkpoint.header.migration_penalty = migrationPenalty;
+        checkpoint.header.cache_decay = cacheDecay;
+        checkpoint.header.affinity_window = affinityWindow;
+        checkpoint.header.aging_interval = agingInterval;
+        checkpoint.header.max_ready = maxReady;
+        checkpoint.header.admission = admissionPolicy;
+        checkpoint.header.placement = placement;
+        checkpoint.header.speed_scaled = speedScaled;
+        checkpoint.core_speeds.assign(coreSpeed, coreSpeed + cores);
+        for (i = 0; i < processes.size(); i++)
+        {
+            checkpoint_index[processes[i]] = i;
+        }
+        checkpoint.bursts = table.GetBursts();
+        checkpoint.header.num_bursts = checkpoint.bursts->size();
+    }
+
+    // Sliding-window time series (throughput, ready queue, utilisation, context switches)
+    TimeSeries *timeseries = NULL;
+    FILE *timeseries_out = NULL;
+    TimeSeries::Format timeseries_format = TimeSeries::Format::CSV;
+    if (timeseries_file != NULL)
+    {
+        size_t len = strlen(timeseries_file);
+        if (len >= 5 && strcmp(timeseries_file + len - 5, ".json") == 0)
+        {
+            timeseries_format = TimeSeries::Format::JSON;
+        }
+        timeseries_out = fopen(timeseries_file, "w");
+        if (timeseries_out == NULL)
+        {
+            std::cerr << "Error: cannot open " << timeseries_file << std::endl;
+            exit(1);
+        }
+        timeseries = new TimeSeries(timeseries_capacity, cores, timeseries_window);
+        if (timeseries_stream)
+        {
+            timeseries->SetStream(timeseries_out, timeseries_format);
+        }
+    }
+
+    // Live metrics for external monitors (see osmonitor)
+    std::vector<double> shm_turn_times;
+    std::vector<double> shm_wait_times;
+    if (shm_name != NULL)
+    {
+        if (cores > SHM_METRICS_MAX_CORES)
+        {
+            std::cerr << "Error: --shm supports at most " << SHM_METRICS_MAX_CORES << " cores" << std::endl;
+            exit(1);
+        }
+        shmMetrics = ShmMetricsCreate(shm_name, cores);
+        if (shmMetrics == NULL)
+        {
+            std::cerr << "Error: cannot create shared memory " << shm_name << std::endl;
+            exit(1);
+        }
+        shm_turn_times.reserve(processes.size());
+        shm_wait_times.reserve(processes.size());
+    }
+
     // Launch 1 scheduling thread per cpu core
+    ProfilerInit(cores);
     std::mutex mutex;
     std::thread *schedule_threads = new std::thread[cores];
+    runStart = timer.now();
     
     for (i = 0; i < cores; i++)
     {
@@ -94,8 +503,15 @@ int main(int argc, char **argv)
     // Main thread work goes here:
     int terminated = 0;
     start_time = timer.now();
-    while(terminated < processes.size())
+    if (resume_file != NULL)
     {
+        start_time -= std::chrono::milliseconds(checkpoint.header.clock_ms);
+    }
+    last_checkpoint = timer.now();
+    std::chrono::high_resolution_clock::time_point scan_start;
+    while(terminated + rejectedCount < processes.size())
+    {
+        scan_start = timer.now();
         terminated = 0;
         for(int i = 0; i < processes.size(); i++)
         {
@@ -105,34 +521,23 @@ int main(int argc, char **argv)
             if(processes[i]->GetState() == Process::State::Terminated)
             {
                 terminated++;
-                if(terminated == processes.size()/2 && flag == 0) {
+                if(terminated == (processes.size() - rejectedCount)/2 && flag == 0) {
                     timeHalf = (time_elapsed.count());
                     throughputFirstHalf = (terminated)/timeHalf;
                     flag++;
                 }
             }
-            else
+            else if(processes[i]->GetState() != Process::State::Rejected)
             {
                 processes[i]->CalcTurnaroundTime(time_since_start.count() * 1000);
             }
             
             if (processes[i]->GetState() == Process::State::NotStarted && (time_elapsed.count() * 1000) >= processes[i]->GetStartTime())
             {
-                processes[i]->SetState(Process::State::Ready);
-                processes[i]->SetReadyQueueEntryTime(timer.now());
                 processes[i]->SetProcessStartTime();
-                if(algorithm == ScheduleAlgorithm::SJF)
-                {
-                    SJFInsert(&ready_queue, processes[i]);
-                }
-                else if(algorithm == ScheduleAlgorithm::PP)
-                {
-                    PPInsert(&ready_queue, processes[i]);
-                }
-                else
-                {
-                    ready_queue.push_back(processes[i]);
-                }    
+                ProfileLock(&mutex, cores);
+                AdmitProcess(algorithm, &ready_queue, &backlog, processes[i]);
+                ProfileUnlock(&mutex, cores);
             }
             else if(processes[i]->GetState() == Process::State::IO) 
             {
@@ -142,18 +547,9 @@ int main(int argc, char **argv)
                     processes[i]->SetState(Process::State::Ready);
                     processes[i]->UpdateCurrentBurst();
                     processes[i]->SetReadyQueueEntryTime(timer.now());
-                    if(algorithm == ScheduleAlgorithm::SJF)
-                    {
-                        SJFInsert(&ready_queue, processes[i]);
-                    }
-                    else if(algorithm == ScheduleAlgorithm::PP)
-                    {
-                        PPInsert(&ready_queue, processes[i]);
-                    }
-                    else
-                    {
-                        ready_queue.push_back(processes[i]);
-                    }                 
+                    ProfileLock(&mutex, cores);
+                    ReadyQueueInsert(algorithm, &ready_queue, processes[i]);
+                    ProfileUnlock(&mutex, cores);
                 }
             }
             else if(processes[i]->GetState() == Process::State::Ready)
@@ -163,14 +559,78 @@ int main(int argc, char **argv)
                 processes[i]->SetReadyQueueEntryTime(timer.now());
             }      
         }
-        //sort ready queue based on scheduling algorithm
+        if (!backlog.empty())
+        {
+            ProfileLock(&mutex, cores);
+            AdmitBacklog(algorithm, &ready_queue, &backlog);
+            ProfileUnlock(&mutex, cores);
+        }
+        ProfileScan(scan_start);
 
+        //publish live metrics
+        if (shmMetrics != NULL)
+        {
+            current_time = timer.now();
+            time_elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(current_time - start_time);
+            ProfileLock(&mutex, cores);
+            uint32_t ready_len = ready_queue.size();
+            ProfileUnlock(&mutex, cores);
+            PublishSummaryMetrics(&processes, &shm_turn_times, &shm_wait_times, time_elapsed.count() * 1000,
+                                  ready_len, terminated, false);
+        }
 
-        for (int i=0; i<linesPrinted; i++) {
-            fputs("\033[A\033[2K", stdout);
+        //sample time series once per window
+        if (timeseries != NULL)
+        {
+            current_time = timer.now();
+            time_elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(current_time - start_time);
+            if (timeseries->WindowElapsed(time_elapsed.count() * 1000))
+            {
+                for (i = 0; i < cores; i++)
+                {
+                    busy_snapshot[i] = coreBusyUs[i].load();
+                }
+                ProfileLock(&mutex, cores);
+                uint32_t ready_len = ready_queue.size();
+                ProfileUnlock(&mutex, cores);
+                timeseries->Record(time_elapsed.count() * 1000, terminated, ready_len,
+                                   busy_snapshot, contextSwitches.load());
+            }
+        }
+
+        //snapshot the run for --resume
+        if (checkpoint_file != NULL && timer.now() - last_checkpoint >= std::chrono::milliseconds(checkpoint_interval))
+        {
+            if (checkpoint_writer.joinable())
+            {
+                checkpoint_writer.join();
+            }
+            current_time = timer.now();
+            CaptureCheckpoint(&checkpoint, processes, checkpoint_index, &ready_queue, &mutex, cores, current_time);
+            checkpoint.header.clock_ms = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - start_time).count();
+            checkpoint.header.context_switches = contextSwitches.load();
+            checkpoint.header.deferred_count = deferredCount;
+            checkpoint.header.peak_ready = peakReady;
+            checkpoint.header.half_flag = flag;
+            checkpoint.header.time_half = timeHalf;
+            checkpoint.header.throughput_first_half = throughputFirstHalf;
+            checkpoint_writer = std::thread([&checkpoint, checkpoint_file]() {
+                if (!WriteCheckpoint(checkpoint_file, checkpoint))
+                {
+                    std::cerr << "Error: cannot write checkpoint " << checkpoint_file << std::endl;
+                }
+            });
+            last_checkpoint = timer.now();
+        }
+
+        if (!quiet)
+        {
+            for (int i=0; i<linesPrinted; i++) {
+                fputs("\033[A\033[2K", stdout);
+            }
+            rewind(stdout);
+            linesPrinted = PrintStatistics(processes, algorithm);
         }
-        rewind(stdout);
-        linesPrinted = PrintStatistics(processes, algorithm);
         //to allow for refresh
         usleep(100000);
     }
@@ -178,7 +638,8 @@ int main(int argc, char **argv)
     current_time = timer.now();
     time_elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(current_time - start_time);
     time2ndHalf = (time_elapsed.count()) - timeHalf;
-    throughputSecondHalf = (processes.size()-processes.size()/2)/time2ndHalf;
+    uint32_t completed = processes.size() - rejectedCount;
+    throughputSecondHalf = (completed-completed/2)/time2ndHalf;
     //          Check state of each process, if not started, check start time and start
     //          if in io check io time and add to ready
     //  - Start new processes at their appropriate start time
@@ -192,20 +653,153 @@ int main(int argc, char **argv)
     {
         schedule_threads[i].join();
     }
+    if (checkpoint_writer.joinable())
+    {
+        checkpoint_writer.join();
+    }
+    if (decisionLog != NULL)
+    {
+        if (!decisionLog->Close())
+        {
+            std::cerr << "Error: cannot write decision log " << decision_log_file << std::endl;
+        }
+        delete decisionLog;
+        decisionLog = NULL;
+    }
 
-    double avgCpuUtil = 0.0;
-    for (i = 0; i < cores; i++)
+    // Record the final (partial) window and write the series out
+    if (timeseries != NULL)
+    {
+        for (i = 0; i < cores; i++)
+        {
+            busy_snapshot[i] = coreBusyUs[i].load();
+        }
+        timeseries->Record(time_elapsed.count() * 1000, terminated, ready_queue.size(),
+                           busy_snapshot, contextSwitches.load());
+        if (!timeseries_stream)
+        {
+            timeseries->Write(timeseries_out, timeseries_format);
+        }
+        fclose(timeseries_out);
+        delete timeseries;
+    }
+
+    // Mark the run finished for monitors; the mapping stays valid for readers after unlink
+    if (shmMetrics != NULL)
     {
-        avgCpuUtil += CPUUtilCore[i];
+        PublishSummaryMetrics(&processes, &shm_turn_times, &shm_wait_times, time_elapsed.count() * 1000,
+                              ready_queue.size(), terminated, true);
+        ShmMetricsClose(shmMetrics);
+        ShmMetricsUnlink(shm_name);
+        shmMetrics = NULL;
+    }
+
+    double avgCpuUtil = MeanOf(CPUUtilCore, cores);
+    ProcessStatistics stats(processes);
+    ColumnSummary turnSummary = stats.GetTurnaroundSummary();
+    ColumnSummary waitSummary = stats.GetWaitSummary();
+    if (output)
+    {
+        ReportSummary summary;
+        summary.elapsed_time = time2ndHalf + timeHalf;
+        summary.cpu_utilization = avgCpuUtil;
+        summary.throughput_first_half = throughputFirstHalf;
+        summary.throughput_second_half = throughputSecondHalf;
+        summary.throughput = completed / (time2ndHalf + timeHalf);
+        summary.avg_turnaround = turnSummary.mean;
+        summary.avg_wait = waitSummary.mean;
+        summary.avg_response = stats.GetResponseSummary().mean;
+        summary.context_switches = contextSwitches.load();
+        summary.deferred = deferredCount;
+        summary.rejected = rejectedCount;
+        summary.peak_ready = peakReady;
+        if (speedScaled)
+        {
+            summary.core_types = GroupCoreTypes(coreSpeed, CPUUtilCore, cores);
+        }
+        WriteReport(output_out, output_format, processes, summary);
+        if (output_file != NULL)
+        {
+            fclose(output_out);
+        }
+    }
+    if (quiet)
+    {
+        ProfilerPrint(std::cerr);
+    }
+    else
+    {
+        std::cout << "CPU Utilization: " << avgCpuUtil << "%\n";
+        for (i = 0; i < cores; i++)
+        {
+            std::cout << "  Core " << i << ": " << CPUUtilCore[i] << "%, migrations in " << coreMigrations[i].load()
+                      << ", migration penalty " << coreMigrationUs[i].load() / 1000000.0 << "s\n";
+        }
+        if (speedScaled)
+        {
+            std::vector<CoreTypeGroup> types = GroupCoreTypes(coreSpeed, CPUUtilCore, cores);
+            for (i = 0; i < types.size(); i++)
+            {
+                std::cout << "  Speed " << types[i].speed << "x (" << types[i].cores << " cores): utilization "
+                          << types[i].utilization << "%\n";
+            }
+        }
+        std::cout << "Average Throughput for First Half: " << throughputFirstHalf << "\n";
+        std::cout << "Average Throughput for Second Half: " << throughputSecondHalf << "\n";
+        std::cout << "Average Throughput: " << completed/(time2ndHalf+timeHalf) << "\n";
+        if (maxReady > 0)
+        {
+            std::cout << "Admission (max ready " << maxReady << "): " << deferredCount << " deferred, "
+                      << rejectedCount << " rejected, peak ready queue " << peakReady << "\n";
+        }
+        std::cout << "Average Turnaround Time: " << turnSummary.mean << "\n";
+        std::cout << "Average Wait Time: " << waitSummary.mean << "\n";
+        std::cout << "Turnaround Time min/max/stddev: " << turnSummary.min << " / " << turnSummary.max
+                  << " / " << turnSummary.stddev << "\n";
+        std::cout << "Wait Time min/max/stddev: " << waitSummary.min << " / " << waitSummary.max
+                  << " / " << waitSummary.stddev << "\n";
+        if (algorithm == ScheduleAlgorithm::PP)
+        {
+            std::vector<PriorityGroup> groups = stats.GetPriorityGroups();
+            for (i = 0; i < groups.size(); i++)
+            {
+                std::cout << "  Priority " << (int)groups[i].priority << ": " << groups[i].count
+                          << " processes, average turnaround " << groups[i].mean_turn
+                          << ", average wait " << groups[i].mean_wait << "\n";
+            }
+        }
+        ProfilerPrint(std::cout);
+    }
+
+    // A replay that ran off the log, or dispatched past its end, did not
+    // reproduce the logged run
+    int status = 0;
+    if (replay_file != NULL)
+    {
+        std::ostream &replay_out = quiet ? std::cerr : std::cout;
+        while (replaying && replayProcesses[replayNext]->GetState() == Process::State::Terminated)
+        {
+            replaySkipped++;
+            replayNext++;
+            replaying = replayNext < replayRecords.size();
+        }
+        if (replayNext == replayRecords.size() && replaySkipped == 0 && dispatchCount == replayRecords.size())
+        {
+            replay_out << "Replay: " << dispatchCount << " dispatches follow " << replay_file << "\n";
+        }
+        else
+        {
+            replay_out << "Replay: followed " << replayNext - replaySkipped << " of " << replayRecords.size()
+                       << " logged decisions (" << replaySkipped << " skipped, process already finished), "
+                       << dispatchCount << " dispatches in all\n";
+            if (replayStop != NULL)
+            {
+                replay_out << "  stopped at decision " << replayNext << ": pid " << replayRecords[replayNext].pid
+                           << " was " << replayStop << "\n";
+            }
+            status = 1;
+        }
     }
-    
-    avgCpuUtil = (avgCpuUtil / cores);
-    std::cout << "CPU Utilization: " << avgCpuUtil << "%\n";
-    std::cout << "Average Throughput for First Half: " << throughputFirstHalf << "\n";
-    std::cout << "Average Throughput for Second Half: " << throughputSecondHalf << "\n";
-    std::cout << "Average Throughput: " << processes.size()/(time2ndHalf+timeHalf) << "\n";
-    std::cout << "Average Turnaround Time: " << printTurnTime(processes) << "\n";
-    std::cout << "Average Wait Time: " << printWaitTime(processes) << "\n";
     
     // Print final statistics
     //  - CPU utilization
@@ -218,12 +812,20 @@ int main(int argc, char **argv)
 
 
     // Clean up before quitting program
-    processes.clear();
+    delete[] schedule_threads;
+    delete[] CPUUtilCore;
+    delete[] coreBusyUs;
+    delete[] coreIdle;
+    delete[] coreMigrations;
+    delete[] coreMigrationUs;
+    delete[] coreSpeed;
+    delete[] busy_snapshot;
+    ProfilerDelete();
 
-    return 0;
+    return status;
 }
 
-void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t context_switch, uint32_t time_slice,
+void ScheduleProcesses(uint16_t core_id, ScheduleAlgorithm algorithm, uint32_t context_switch, uint32_t time_slice,
                        std::list<Process*> *ready_queue, std::mutex *mutex)
 {
     Process* currentProcess;
@@ -232,29 +834,36 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
     std::chrono::high_resolution_clock::time_point end;
     std::chrono::duration<double> time_elapsed;
     uint32_t slice_elapsed;
+    uint32_t work;
+    double work_carry = 0.0;
     uint32_t burst_elapsed = 0;
     uint32_t burst_time;
     std::chrono::high_resolution_clock::time_point before;
     std::chrono::high_resolution_clock::time_point after;
     std::chrono::high_resolution_clock::time_point threadstarted = timer.now();
     std::chrono::duration<double> cpuUtil;
+    std::chrono::high_resolution_clock::time_point last_publish = threadstarted;
+    uint32_t switches = 0;
     
     while(!processesTerminated)
     {
         if(algorithm == ScheduleAlgorithm::FCFS || algorithm == ScheduleAlgorithm::SJF)
         {
-            mutex->lock();
+            ProfileLock(mutex, core_id);
             //Get process at front of ready queue
-            if(!ready_queue->empty())
+            if(!ready_queue->empty() && ReplayTurn(ready_queue, core_id, NULL))
             {
                 before = timer.now();
                 start = timer.now();
-                currentProcess = ready_queue->front();
-                ready_queue->pop_front();
-                mutex->unlock();
+                currentProcess = PickProcess(ready_queue, core_id, algorithm);
+                ProfileDispatch(core_id, currentProcess->GetReadySince());
+                ProfileUnlock(mutex, core_id);
                 currentProcess->SetCpuCore(core_id);
+                MigrateProcess(currentProcess, core_id);
+                work_carry = 0.0;
+                start = timer.now();
                 burst_time = currentProcess->GetBurstTime();
-                burst_elapsed = 0;
+                burst_elapsed = currentProcess->GetBurstElapsed();
                 while(burst_elapsed < burst_time && currentProcess->GetRemainingTime() > 0)
                 {
                     //Simulate Process running
@@ -262,13 +871,17 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
                     currentProcess->SetState(Process::State::Running);
                     end = timer.now();
                     time_elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
-                    currentProcess->SetRemainingTime(time_elapsed.count() * 1000);
+                    work = CoreWork(core_id, time_elapsed.count() * 1000, &work_carry);
+                    currentProcess->SetRemainingTime(work);
                     start = timer.now();
                     currentProcess->CalcCpuTime(time_elapsed.count() * 1000);
-                    burst_elapsed = burst_elapsed + (time_elapsed.count() * 1000);
-                    
+                    coreBusyUs[core_id] += time_elapsed.count() * 1000000;
+                    PublishCoreMetrics(core_id, currentProcess->GetPid(), switches, threadstarted);
+                    burst_elapsed = burst_elapsed + work;
+                    currentProcess->SetBurstElapsed(work);
                 }
                 currentProcess->UpdateCurrentBurst();
+                currentProcess->SetBurstElapsed(currentProcess->GetBurstElapsed() * -1);
                 if(currentProcess->GetRemainingTime() <= 0)
                 {
                     //update CPU utilization for this core
@@ -277,6 +890,7 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
                     //update process status information
                     currentProcess->SetCpuCore(-1);
                     currentProcess->SetState(Process::State::Terminated);
+                    admittedLive--;
                     
                 }
                 else
@@ -289,25 +903,36 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
                     currentProcess->SetState(Process::State::IO);
                     currentProcess->SetBurstStartTime();
                     //wait context switching time
+                    contextSwitches++;
+                    switches++;
                     usleep(context_switch);
                 }    
             }          
-            else 
+            else
             {
-                mutex->unlock();
+                ProfileUnlock(mutex, core_id);
+                ProfileIdleSpin(core_id);
+                coreIdle[core_id] = true;
+                if (shmMetrics != NULL && timer.now() - last_publish >= std::chrono::milliseconds(1))
+                {
+                    PublishCoreMetrics(core_id, -1, switches, threadstarted);
+                    last_publish = timer.now();
+                }
             }
         }
         else if(algorithm == ScheduleAlgorithm::PP)
         {
-            mutex->lock();
+            ProfileLock(mutex, core_id);
             //Get process at front of ready queue
-            if(!ready_queue->empty())
+            if(!ready_queue->empty() && ReplayTurn(ready_queue, core_id, NULL))
             {
                 before = timer.now();
-                currentProcess = ready_queue->front();
-                ready_queue->pop_front();
-                mutex->unlock();
+                currentProcess = PickProcess(ready_queue, core_id, algorithm);
+                ProfileDispatch(core_id, currentProcess->GetReadySince());
+                ProfileUnlock(mutex, core_id);
                 currentProcess->SetCpuCore(core_id);
+                MigrateProcess(currentProcess, core_id);
+                work_carry = 0.0;
                 burst_time = currentProcess->GetBurstTime();
                 burst_elapsed = currentProcess->GetBurstElapsed();
                 while(burst_elapsed < burst_time && currentProcess->GetRemainingTime() > 0)
@@ -318,34 +943,45 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
                     currentProcess->SetState(Process::State::Running);
                     end = timer.now();
                     time_elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
-                    currentProcess->SetRemainingTime(time_elapsed.count() * 1000);
+                    work = CoreWork(core_id, time_elapsed.count() * 1000, &work_carry);
+                    currentProcess->SetRemainingTime(work);
                     currentProcess->CalcCpuTime(time_elapsed.count() * 1000);
-                    burst_elapsed = burst_elapsed + (time_elapsed.count() * 1000);
-                    currentProcess->SetBurstElapsed(time_elapsed.count() * 1000);
-                    mutex->lock();
-                    if(!ready_queue->empty() && ready_queue->front()->GetPriority() < currentProcess->GetPriority())
+                    coreBusyUs[core_id] += time_elapsed.count() * 1000000;
+                    PublishCoreMetrics(core_id, currentProcess->GetPid(), switches, threadstarted);
+                    burst_elapsed = burst_elapsed + work;
+                    currentProcess->SetBurstElapsed(work);
+                    ProfileLock(mutex, core_id);
+                    if(!ready_queue->empty() &&
+                       EffectivePriority(ready_queue->front(), timer.now()) < currentProcess->GetEffectivePriority() &&
+                       ReplayTurn(ready_queue, core_id, currentProcess))
                     {
                         //Put process in ready queue then pop front of ready queue
-                        
+                        currentProcess->UpdatePreemptions();
                         currentProcess->SetCpuCore(-1);
                         currentProcess->SetState(Process::State::Ready);
-                        PPInsert(ready_queue, currentProcess);
-                        currentProcess = ready_queue->front();
-                        ready_queue->pop_front();
-                        mutex->unlock();
+                        currentProcess->SetReadySince(timer.now());
+                        Process *preempted = currentProcess;
+                        currentProcess = PickProcess(ready_queue, core_id, algorithm);
+                        PPInsert(ready_queue, preempted);
+                        ProfileDispatch(core_id, currentProcess->GetReadySince());
+                        ProfileUnlock(mutex, core_id);
                         
                         after = timer.now();
                         cpuUtil += std::chrono::duration_cast<std::chrono::duration<double>>(after-before);
                         //wait context switching time
+                        contextSwitches++;
+                        switches++;
                         usleep(context_switch);
                         before = timer.now();
                         currentProcess->SetCpuCore(core_id);
+                        MigrateProcess(currentProcess, core_id);
+                        work_carry = 0.0;
                         burst_time = currentProcess->GetBurstTime();
                         burst_elapsed = currentProcess->GetBurstElapsed();
                     }
                     else 
                     {
-                        mutex->unlock();
+                        ProfileUnlock(mutex, core_id);
                     }
                 }
                 currentProcess->UpdateCurrentBurst();
@@ -358,6 +994,7 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
                     //update process status information
                     currentProcess->SetCpuCore(-1);
                     currentProcess->SetState(Process::State::Terminated);
+                    admittedLive--;
                 }
                 else
                 {
@@ -369,25 +1006,36 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
                     currentProcess->SetState(Process::State::IO);
                     currentProcess->SetBurstStartTime();
                     //wait context switching time
+                    contextSwitches++;
+                    switches++;
                     usleep(context_switch);
                 }
             }
             else
             {
-                mutex->unlock();
+                ProfileUnlock(mutex, core_id);
+                ProfileIdleSpin(core_id);
+                coreIdle[core_id] = true;
+                if (shmMetrics != NULL && timer.now() - last_publish >= std::chrono::milliseconds(1))
+                {
+                    PublishCoreMetrics(core_id, -1, switches, threadstarted);
+                    last_publish = timer.now();
+                }
             }
         }
         else if(algorithm == ScheduleAlgorithm::RR)
         {
-            mutex->lock();
+            ProfileLock(mutex, core_id);
             //Get process at front of ready queue
-            if(!ready_queue->empty())
+            if(!ready_queue->empty() && ReplayTurn(ready_queue, core_id, NULL))
             {
                 before = timer.now();
-                currentProcess = ready_queue->front();
-                ready_queue->pop_front();
-                mutex->unlock();
+                currentProcess = PickProcess(ready_queue, core_id, algorithm);
+                ProfileDispatch(core_id, currentProcess->GetReadySince());
+                ProfileUnlock(mutex, core_id);
                 currentProcess->SetCpuCore(core_id);
+                MigrateProcess(currentProcess, core_id);
+                work_carry = 0.0;
                 burst_time = currentProcess->GetBurstTime();
                 burst_elapsed = 0;
                 while(currentProcess->GetBurstElapsed() < burst_time && currentProcess->GetRemainingTime() > 0)
@@ -398,27 +1046,54 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
                     usleep(1000);
                     end = timer.now();
                     time_elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
-                    currentProcess->SetRemainingTime(time_elapsed.count() * 1000);
+                    work = CoreWork(core_id, time_elapsed.count() * 1000, &work_carry);
+                    currentProcess->SetRemainingTime(work);
                     currentProcess->CalcCpuTime(time_elapsed.count() * 1000);
+                    coreBusyUs[core_id] += time_elapsed.count() * 1000000;
+                    PublishCoreMetrics(core_id, currentProcess->GetPid(), switches, threadstarted);
+                    //the time slice is wall time on the core, not burst progress
                     burst_elapsed = burst_elapsed + (time_elapsed.count() * 1000);
-                    currentProcess->SetBurstElapsed(time_elapsed.count() * 1000);
+                    currentProcess->SetBurstElapsed(work);
                     if(burst_elapsed > time_slice)
                     {
+                        //during a replay the core holds the process, doing no
+                        //work, until its logged turn to switch
+                        while (!ReplaySliceEnds(ready_queue, mutex, core_id, currentProcess))
+                        {
+                            usleep(1000);
+                        }
+                        currentProcess->UpdatePreemptions();
                         currentProcess->SetState(Process::State::Ready);
                         currentProcess->SetCpuCore(-1);
                         after = timer.now();
                         cpuUtil += std::chrono::duration_cast<std::chrono::duration<double>>(after-before);
                         
                         //Perform context switch
+                        contextSwitches++;
+                        switches++;
                         usleep(context_switch);
-                        mutex->lock();
-                        ready_queue->push_back(currentProcess);
-                        currentProcess = ready_queue->front();
-                        ready_queue->pop_front();
-                        mutex->unlock();
+                        ProfileLock(mutex, core_id);
+                        currentProcess->SetReadySince(timer.now());
+                        //pick before requeueing so the core moves on to another
+                        //process, unless a replay hands it straight back
+                        if (ready_queue->empty() || replaying)
+                        {
+                            ready_queue->push_back(currentProcess);
+                            currentProcess = PickProcess(ready_queue, core_id, algorithm);
+                        }
+                        else
+                        {
+                            Process *preempted = currentProcess;
+                            currentProcess = PickProcess(ready_queue, core_id, algorithm);
+                            ready_queue->push_back(preempted);
+                        }
+                        ProfileDispatch(core_id, currentProcess->GetReadySince());
+                        ProfileUnlock(mutex, core_id);
                         before = timer.now();
 
                         currentProcess->SetCpuCore(core_id);
+                        MigrateProcess(currentProcess, core_id);
+                        work_carry = 0.0;
                         burst_time = currentProcess->GetBurstTime();
                         burst_elapsed = 0;
                     }
@@ -433,6 +1108,7 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
                     //update process status information
                     currentProcess->SetCpuCore(-1);
                     currentProcess->SetState(Process::State::Terminated);
+                    admittedLive--;
                     after = timer.now();
                 }
                 else
@@ -445,12 +1121,21 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
                     currentProcess->SetState(Process::State::IO);
                     currentProcess->SetBurstStartTime();
                     //wait context switching time
+                    contextSwitches++;
+                    switches++;
                     usleep(context_switch);
                 }
             }
             else
             {
-                mutex->unlock();
+                ProfileUnlock(mutex, core_id);
+                ProfileIdleSpin(core_id);
+                coreIdle[core_id] = true;
+                if (shmMetrics != NULL && timer.now() - last_publish >= std::chrono::milliseconds(1))
+                {
+                    PublishCoreMetrics(core_id, -1, switches, threadstarted);
+                    last_publish = timer.now();
+                }
             }
         }
     }
@@ -458,25 +1143,14 @@ void ScheduleProcesses(uint8_t core_id, ScheduleAlgorithm algorithm, uint32_t co
     after = timer.now();
     time_elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(after - threadstarted);
     
-    if (core_id == 0) {
-    CPUUtilCore[0] = (cpuUtil.count()/time_elapsed.count())*100;
-    }
-    else if (core_id == 1) {
-    CPUUtilCore[1] = (cpuUtil.count()/time_elapsed.count())*100;
-    }
-    else if (core_id == 2) {
-    CPUUtilCore[2] = (cpuUtil.count()/time_elapsed.count())*100;
-    }
-    else if (core_id == 3) {
-    CPUUtilCore[3] = (cpuUtil.count()/time_elapsed.count())*100;
-    }
+    CPUUtilCore[core_id] = (cpuUtil.count()/time_elapsed.count())*100;
     return;
 }
 
-int PrintStatistics(std::vector<Process*> processes, ScheduleAlgorithm algorithm) {
+int PrintStatistics(const std::vector<Process*> &processes, ScheduleAlgorithm algorithm) {
     int linesPrinted = 2;
-    std::cout << "|   PID | Priority |       State | Core |  Turn Time |  Wait Time |   CPU Time | Remain Time |\n";
-    std::cout << "+-------+----------+-------------+------+------------+------------+------------+-------------+\n";
+    std::cout << "|   PID | Priority |       State | Core |  Turn Time |  Wait Time |   CPU Time | Remain Time | Migr |  Migr Time |\n";
+    std::cout << "+-------+----------+-------------+------+------------+------------+------------+-------------+------+------------+\n";
     for(int i = 0; i<processes.size(); i++){
         if (processes[i]->GetState() != Process::State::NotStarted) {
             linesPrinted++;
@@ -488,7 +1162,9 @@ int PrintStatistics(std::vector<Process*> processes, ScheduleAlgorithm algorithm
             std::string waitTime = std::to_string(processes[i]->GetWaitTime());
             std::string cpuTime = std::to_string(processes[i]->GetCpuTime());
             std::string remTime = std::to_string(processes[i]->GetRemainingTime());
-            processLine = "|       |          |             |      |            |            |            |             |\n";
+            std::string migrations = std::to_string(processes[i]->GetMigrations());
+            std::string migrTime = std::to_string(processes[i]->GetMigrationTime());
+            processLine = "|       |          |             |      |            |            |            |             |      |            |\n";
 
             //PID
             int k = 6;
@@ -525,6 +1201,26 @@ int PrintStatistics(std::vector<Process*> processes, ScheduleAlgorithm algorithm
                 processLine[30] = '/';
                 processLine[31] = 'o';
             }
+            else if(processes[i]->GetState() == Process::State::Deferred) {
+                processLine[24] = 'd';
+                processLine[25] = 'e';
+                processLine[26] = 'f';
+                processLine[27] = 'e';
+                processLine[28] = 'r';
+                processLine[29] = 'r';
+                processLine[30] = 'e';
+                processLine[31] = 'd';
+            }
+            else if(processes[i]->GetState() == Process::State::Rejected) {
+                processLine[24] = 'r';
+                processLine[25] = 'e';
+                processLine[26] = 'j';
+                processLine[27] = 'e';
+                processLine[28] = 'c';
+                processLine[29] = 't';
+                processLine[30] = 'e';
+                processLine[31] = 'd';
+            }
             else if(processes[i]->GetState() == Process::State::Terminated){
                 processLine[22] = 't';
                 processLine[23] = 'e';
@@ -569,6 +1265,18 @@ int PrintStatistics(std::vector<Process*> processes, ScheduleAlgorithm algorithm
                 processLine[k] = remTime[j];
                 k--;
             }
+            //Migrations
+            k = 98;
+            for(int j = migrations.length()-1; j >= 0; j--) {
+                processLine[k] = migrations[j];
+                k--;
+            }
+            //Migration Time
+            k = 111;
+            for(int j = migrTime.length()-1; j >= 0; j--) {
+                processLine[k] = migrTime[j];
+                k--;
+            }
             //print current processes line
             std::cout << processLine;
         }
@@ -577,22 +1285,6 @@ int PrintStatistics(std::vector<Process*> processes, ScheduleAlgorithm algorithm
     return linesPrinted;
 }
 
-double printTurnTime(std::vector<Process*> processes) {
-    double avgTurnTime = 0.0;
-    for (int i = 0; i < processes.size(); i++) {
-        avgTurnTime += processes[i]->GetTurnaroundTime();
-    }
-    return avgTurnTime/processes.size();
-}
-
-double printWaitTime(std::vector<Process*> processes) {
-    double avgWaitTime = 0.0;
-    for (int i = 0; i < processes.size(); i++) {
-        avgWaitTime += processes[i]->GetWaitTime();
-    }
-    return avgWaitTime/processes.size();
-}
-
 void SJFInsert(std::list<Process*> *ready_queue, Process* currentProcess)
 {
     std::list<Process*>::iterator it;
@@ -611,9 +1303,329 @@ void SJFInsert(std::list<Process*> *ready_queue, Process* currentProcess)
     return;
 }
 
+void ReadyQueueInsert(ScheduleAlgorithm algorithm, std::list<Process*> *ready_queue, Process* currentProcess)
+{
+    currentProcess->SetReadySince(std::chrono::high_resolution_clock::now());
+    QueueInsert(algorithm, ready_queue, currentProcess);
+}
+
+// Insert in the algorithm's order keeping the process's ready_since, as a
+// resume does so that aging carries over from the checkpoint. This is the only
+// way the queue grows (preemptions pick before requeueing), so the peak depth
+// is taken here.
+void QueueInsert(ScheduleAlgorithm algorithm, std::list<Process*> *ready_queue, Process* currentProcess)
+{
+    if (ready_queue->size() + 1 > peakReady)
+    {
+        peakReady = ready_queue->size() + 1;
+    }
+    if(algorithm == ScheduleAlgorithm::SJF)
+    {
+        SJFInsert(ready_queue, currentProcess);
+    }
+    else if(algorithm == ScheduleAlgorithm::PP)
+    {
+        PPInsert(ready_queue, currentProcess);
+    }
+    else
+    {
+        ready_queue->push_back(currentProcess);
+    }
+    return;
+}
+
+// Called with the ready queue locked, for new arrivals only: processes coming
+// back from I/O or a preemption are already in the system and always queue.
+// max_ready therefore bounds the processes in the system (admitted and not yet
+// terminated: ready, running or in I/O), which also bounds the ready queue. An
+// arrival is admitted only while that count is below it and nobody is waiting
+// in the backlog ahead of it.
+void AdmitProcess(ScheduleAlgorithm algorithm, std::list<Process*> *ready_queue, std::deque<Process*> *backlog,
+                  Process* currentProcess)
+{
+    if (maxReady == 0 || (backlog->empty() && admittedLive < maxReady))
+    {
+        admittedLive++;
+        currentProcess->SetState(Process::State::Ready);
+        currentProcess->SetReadyQueueEntryTime(std::chrono::high_resolution_clock::now());
+        ReadyQueueInsert(algorithm, ready_queue, currentProcess);
+    }
+    else if (admissionPolicy == AdmissionPolicy::Reject)
+    {
+        currentProcess->SetState(Process::State::Rejected);
+        rejectedCount++;
+    }
+    else
+    {
+        currentProcess->SetState(Process::State::Deferred);
+        deferredCount++;
+        backlog->push_back(currentProcess);
+    }
+    return;
+}
+
+// Called with the ready queue locked; admits deferred arrivals in order as
+// terminations make room.
+void AdmitBacklog(ScheduleAlgorithm algorithm, std::list<Process*> *ready_queue, std::deque<Process*> *backlog)
+{
+    while (!backlog->empty() && admittedLive < maxReady)
+    {
+        admittedLive++;
+        Process *p = backlog->front();
+        backlog->pop_front();
+        p->SetState(Process::State::Ready);
+        p->SetReadyQueueEntryTime(std::chrono::high_resolution_clock::now());
+        ReadyQueueInsert(algorithm, ready_queue, p);
+    }
+    return;
+}
+
+// Called with the ready queue locked. During a replay it takes the logged
+// process (ReplayTurn has checked it is queued). With speed-aware placement
+// a core slower than the fastest looks at the first affinityWindow entries (only
+// those tied with the front under PP) and takes the one with the least work
+// left, leaving longer work to the fast cores. Otherwise, with the warm-cache
+// model enabled, it looks at the same window and takes one that last ran
+// here; failing that, the first one that is cheap to move or whose last core
+// is busy. Otherwise the front.
+Process* PickProcess(std::list<Process*> *ready_queue, uint16_t core_id, ScheduleAlgorithm algorithm)
+{
+    std::list<Process*>::iterator it;
+    std::list<Process*>::iterator pick = ready_queue->end();
+    if (replaying)
+    {
+        pick = std::find(ready_queue->begin(), ready_queue->end(), replayProcesses[replayNext]);
+        if (pick == ready_queue->end())
+        {
+            replaying = false;
+            replayStop = "not in the ready queue";
+        }
+        else
+        {
+            replayNext++;
+            replaying = replayNext < replayRecords.size();
+        }
+    }
+    if (pick == ready_queue->end() && placement == Placement::Speed && coreSpeed[core_id] < fastestSpeed)
+    {
+        std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+        uint8_t front_priority = EffectivePriority(ready_queue->front(), now);
+        int seen = 0;
+        for (it = ready_queue->begin(); it != ready_queue->end() && seen < affinityWindow; ++it, ++seen)
+        {
+            if (algorithm == ScheduleAlgorithm::PP && EffectivePriority(*it, now) != front_priority)
+            {
+                break;
+            }
+            if (pick == ready_queue->end() || (*it)->GetRemainingTime() < (*pick)->GetRemainingTime())
+            {
+                pick = it;
+            }
+        }
+    }
+    else if (pick == ready_queue->end() && migrationPenalty > 0 && affinityWindow > 1)
+    {
+        std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+        uint8_t front_priority = EffectivePriority(ready_queue->front(), now);
+        int seen = 0;
+        for (it = ready_queue->begin(); it != ready_queue->end() && seen < affinityWindow; ++it, ++seen)
+        {
+            if (algorithm == ScheduleAlgorithm::PP && EffectivePriority(*it, now) != front_priority)
+            {
+                break;
+            }
+            int16_t last = (*it)->GetLastCore();
+            if (last == core_id)
+            {
+                pick = it;
+                break;
+            }
+            if (pick == ready_queue->end() &&
+                (last == -1 || !coreIdle[last] || MigrationPenalty(*it, core_id) < migrationPenalty / 4))
+            {
+                pick = it;
+            }
+        }
+    }
+    if (pick == ready_queue->end())
+    {
+        pick = ready_queue->begin();
+    }
+    Process *p = *pick;
+    ready_queue->erase(pick);
+    coreIdle[core_id] = false;
+    dispatchCount++;
+    std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+    p->SetEffectivePriority(EffectivePriority(p, now));
+    p->CalcResponseTime(std::chrono::duration_cast<std::chrono::milliseconds>(now - p->GetProcessStartTime()).count());
+    if (decisionLog != NULL)
+    {
+        decisionLog->Record(std::chrono::duration_cast<std::chrono::microseconds>(now - runStart).count(),
+                            p->GetPid(), core_id);
+    }
+    return p;
+}
+
+// Called with the ready queue locked. Outside a replay any core may dispatch.
+// During one a core only dispatches when the next logged decision is its own
+// and the logged process is queued, or is currentProcess, which RR may hand
+// straight back. Burst progress is wall time, so a process can finish a tick
+// sooner than it did in the logged run; its remaining logged dispatches are
+// skipped. The replay ends early, leaving the cores to pick freely, once the
+// logged process can never be dispatched: it was rejected, or every core is
+// idle or waiting for its turn while the process is held back by admission
+// control or held by one of those waiting cores.
+bool ReplayTurn(std::list<Process*> *ready_queue, uint16_t core_id, Process* currentProcess)
+{
+    int i;
+    while (replaying && replayProcesses[replayNext]->GetState() == Process::State::Terminated)
+    {
+        replaySkipped++;
+        replayNext++;
+        replaying = replayNext < replayRecords.size();
+    }
+    if (!replaying)
+    {
+        return true;
+    }
+    Process *p = replayProcesses[replayNext];
+    if (replayRecords[replayNext].core == core_id &&
+        (p == currentProcess || std::find(ready_queue->begin(), ready_queue->end(), p) != ready_queue->end()))
+    {
+        return true;
+    }
+    bool stuck = p->GetState() == Process::State::Rejected;
+    if (p->GetState() == Process::State::Deferred || p->GetState() == Process::State::Running)
+    {
+        stuck = true;
+        for (i = 0; i < coreCount; i++)
+        {
+            stuck = stuck && coreIdle[i];
+        }
+    }
+    if (stuck)
+    {
+        replaying = false;
+        if (p->GetState() == Process::State::Deferred)
+        {
+            replayStop = "held back by admission control";
+        }
+        else if (p->GetState() == Process::State::Running)
+        {
+            replayStop = "held by a core waiting for its own turn";
+        }
+        else
+        {
+            replayStop = "rejected";
+        }
+        return true;
+    }
+    return false;
+}
+
+// RR slice expiry. During a replay the slice only ends on this core's logged
+// turn; the core counts as idle while it waits.
+bool ReplaySliceEnds(std::list<Process*> *ready_queue, std::mutex *mutex, uint16_t core_id, Process* currentProcess)
+{
+    if (!replaying)
+    {
+        return true;
+    }
+    ProfileLock(mutex, core_id);
+    bool turn = ReplayTurn(ready_queue, core_id, currentProcess);
+    coreIdle[core_id] = !turn;
+    ProfileUnlock(mutex, core_id);
+    return turn;
+}
+
+// Cold-cache cost (us) of running on core_id, decaying with time spent away
+// from the last core. Zero when the process stays put or has not run yet.
+int32_t MigrationPenalty(Process* currentProcess, uint16_t core_id)
+{
+    int16_t last = currentProcess->GetLastCore();
+    if (last == -1 || last == core_id || migrationPenalty == 0)
+    {
+        return 0;
+    }
+    if (cacheDecay == 0)
+    {
+        return migrationPenalty;
+    }
+    std::chrono::duration<double> away = std::chrono::high_resolution_clock::now() - currentProcess->GetLastRunEnd();
+    return migrationPenalty * std::exp(-(away.count() * 1000.0) / cacheDecay);
+}
+
+// Record a migration onto core_id and spend its warm-up penalty on that core.
+void MigrateProcess(Process* currentProcess, uint16_t core_id)
+{
+    int16_t last = currentProcess->GetLastCore();
+    if (last == -1 || last == core_id)
+    {
+        return;
+    }
+    int32_t penalty = MigrationPenalty(currentProcess, core_id);
+    currentProcess->CalcMigrationTime(penalty);
+    coreMigrations[core_id]++;
+    coreMigrationUs[core_id] += penalty;
+    if (penalty > 0)
+    {
+        usleep(penalty);
+        coreBusyUs[core_id] += penalty;
+    }
+    return;
+}
+
+// Burst progress (ms) made in elapsed_ms of wall time on core_id. Without
+// core_speeds this is the elapsed time truncated to whole ms, as it always
+// was; with them the fraction is carried into the core's next tick, since a
+// slow core can do less than 1 ms of work per tick. The carry belongs to the
+// process on the core and is dropped at each dispatch.
+uint32_t CoreWork(uint16_t core_id, double elapsed_ms, double *carry)
+{
+    if (!speedScaled)
+    {
+        return elapsed_ms;
+    }
+    double work = elapsed_ms * coreSpeed[core_id] + *carry;
+    uint32_t done = work;
+    *carry = work - done;
+    return done;
+}
+
+// Effective priority of a queued process after aging (see aging.h).
+uint8_t EffectivePriority(Process* currentProcess, std::chrono::high_resolution_clock::time_point now)
+{
+    if (agingInterval == 0)
+    {
+        return currentProcess->GetPriority();
+    }
+    return AgedPriority(currentProcess->GetPriority(), EpochMs(currentProcess->GetReadySince()), EpochMs(now), agingInterval);
+}
+
+uint64_t EpochMs(std::chrono::high_resolution_clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count();
+}
+
+// With aging the queue is kept in AgingKey order, which stays the effective
+// priority order without re-sorting; ready_since must already be set.
 void PPInsert(std::list<Process*> *ready_queue, Process* currentProcess)
 {
     std::list<Process*>::iterator it;
+    if (agingInterval > 0)
+    {
+        uint64_t key = AgingKey(currentProcess->GetPriority(), EpochMs(currentProcess->GetReadySince()), agingInterval);
+        for(it = ready_queue->begin(); it != ready_queue->end(); ++it)
+        {
+            if(key < AgingKey((*it)->GetPriority(), EpochMs((*it)->GetReadySince()), agingInterval))
+            {
+                ready_queue->insert(it, currentProcess);
+                return;
+            }
+        }
+        ready_queue->push_back(currentProcess);
+        return;
+    }
     for(it = ready_queue->begin(); it != ready_queue->end(); ++it)
     {
         if(currentProcess->GetPriority() < (*it)->GetPriority())
@@ -628,3 +1640,102 @@ void PPInsert(std::list<Process*> *ready_queue, Process* currentProcess)
     }
     return;
 }
+
+void PublishCoreMetrics(uint16_t core_id, int32_t pid, uint32_t context_switches,
+                        std::chrono::high_resolution_clock::time_point threadstarted)
+{
+    if (shmMetrics == NULL)
+    {
+        return;
+    }
+    ShmCoreData data;
+    uint64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - threadstarted).count();
+    data.pid = pid;
+    data.context_switches = context_switches;
+    data.busy_us = coreBusyUs[core_id].load(std::memory_order_relaxed);
+    data.idle_us = (elapsed_us > data.busy_us) ? elapsed_us - data.busy_us : 0;
+    ShmPublishCore(shmMetrics, core_id, data);
+}
+
+void PublishSummaryMetrics(std::vector<Process*> *processes, std::vector<double> *turn_times,
+                           std::vector<double> *wait_times, uint32_t elapsed_ms, uint32_t ready_queue_len,
+                           uint32_t completed, bool finished)
+{
+    ShmSummaryData data;
+    turn_times->clear();
+    wait_times->clear();
+    for (int i = 0; i < processes->size(); i++)
+    {
+        if ((*processes)[i]->GetState() == Process::State::Terminated)
+        {
+            turn_times->push_back((*processes)[i]->GetTurnaroundTime());
+            wait_times->push_back((*processes)[i]->GetWaitTime());
+        }
+    }
+    data.elapsed_ms = elapsed_ms;
+    data.ready_queue_len = ready_queue_len;
+    data.completed = completed;
+    data.total = processes->size();
+    data.finished = finished;
+    data.turn_p50 = Percentile(turn_times, 0.50);
+    data.turn_p90 = Percentile(turn_times, 0.90);
+    data.turn_p99 = Percentile(turn_times, 0.99);
+    data.wait_p50 = Percentile(wait_times, 0.50);
+    data.wait_p90 = Percentile(wait_times, 0.90);
+    data.wait_p99 = Percentile(wait_times, 0.99);
+    ShmPublishSummary(shmMetrics, data);
+}
+
+double Percentile(std::vector<double> *values, double pct)
+{
+    if (values->empty())
+    {
+        return 0.0;
+    }
+    std::vector<double>::iterator nth = values->begin() + (size_t)(pct * (values->size() - 1));
+    std::nth_element(values->begin(), nth, values->end());
+    return *nth;
+}
+
+// Fills checkpoint with the ready queue order and a snapshot of every process.
+// Only the pointer copy happens under the lock; workers keep running while the
+// process table is read, so a process may change state between the two and
+// resume sorts that out from the process states.
+void CaptureCheckpoint(Checkpoint *checkpoint, const std::vector<Process*> &processes,
+                       const std::unordered_map<Process*, uint32_t> &index, std::list<Process*> *ready_queue,
+                       std::mutex *mutex, uint16_t cores, std::chrono::high_resolution_clock::time_point now)
+{
+    std::vector<Process*> order;
+    ProfileLock(mutex, cores);
+    order.assign(ready_queue->begin(), ready_queue->end());
+    ProfileUnlock(mutex, cores);
+
+    uint32_t i;
+    checkpoint->processes.resize(processes.size());
+    checkpoint->ready_queue.clear();
+    for (i = 0; i < processes.size(); i++)
+    {
+        processes[i]->Snapshot(&checkpoint->processes[i], now);
+        if (checkpoint->processes[i].state == Process::State::Running)
+        {
+            checkpoint->ready_queue.push_back(i);
+        }
+    }
+    for (i = 0; i < order.size(); i++)
+    {
+        checkpoint->ready_queue.push_back(index.at(order[i]));
+    }
+    checkpoint->core_busy_us.resize(cores);
+    checkpoint->core_migrations.resize(cores);
+    checkpoint->core_migration_us.resize(cores);
+    for (i = 0; i < cores; i++)
+    {
+        checkpoint->core_busy_us[i] = coreBusyUs[i].load();
+        checkpoint->core_migrations[i] = coreMigrations[i].load();
+        checkpoint->core_migration_us[i] = coreMigrationUs[i].load();
+    }
+    checkpoint->header.num_processes = processes.size();
+    checkpoint->header.ready_queue_len = checkpoint->ready_queue.size();
+    return;
+}
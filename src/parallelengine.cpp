@@ -0,0 +1,616 @@
+#include "parallelengine.h"
+#include <algorithm>
+#include <barrier>
+#include <limits>
+#include <thread>
+
+static uint64_t Mix(uint64_t x)
+{
+    // splitmix64 finaliser
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+ParallelEngine::ParallelEngine(uint16_t cores, ScheduleAlgorithm algorithm, uint32_t context_switch, uint32_t time_slice,
+                               uint16_t threads, SimTime migration_latency, uint64_t seed)
+{
+    int i;
+    this->cores = cores;
+    this->threads = (threads == 0) ? 1 : ((threads > cores) ? cores : threads);
+    this->algorithm = algorithm;
+    this->context_switch = context_switch;
+    this->time_slice = time_slice;
+    this->migration_latency = (migration_latency == 0) ? 1 : migration_latency;
+    lookahead = this->migration_latency;
+    this->seed = seed;
+    window_end = 0;
+    windows = 0;
+    done = false;
+    log_decisions = false;
+    aging_interval = 0;
+    cores_per_partition = (cores + this->threads - 1) / this->threads;
+
+    core.resize(cores);
+    load.assign(cores, 0);
+    for (i = 0; i < cores; i++)
+    {
+        core[i].running = NULL;
+        core[i].run_start = 0;
+        core[i].run_end = 0;
+        core[i].result_ms = 0;
+        core[i].gen = 0;
+        core[i].preempting = false;
+        core[i].switching = false;
+        core[i].has_pending = false;
+        core[i].seq = 0;
+        core[i].busy_us = 0;
+        core[i].context_switches = 0;
+        core[i].migrations = 0;
+        core[i].peak_ready = 0;
+    }
+    partition.resize(this->threads);
+    for (i = 0; i < this->threads; i++)
+    {
+        partition[i].first_core = std::min<int>(i * cores_per_partition, cores);
+        partition[i].last_core = std::min<int>((i + 1) * cores_per_partition, cores);
+        partition[i].now = 0;
+        partition[i].next_time = 0;
+        partition[i].events_processed = 0;
+    }
+}
+
+ParallelEngine::Partition* ParallelEngine::PartitionOf(uint16_t core_id)
+{
+    return &partition[core_id / cores_per_partition];
+}
+
+void ParallelEngine::Schedule(uint16_t core_id, SimTime time, EventKind kind, std::coroutine_handle<> handle,
+                              uint32_t id, uint32_t gen)
+{
+    PEvent e;
+    e.time = time;
+    e.handle = handle;
+    e.id = id;
+    e.gen = gen;
+    e.core = core_id;
+    e.kind = kind;
+    PartitionOf(core_id)->events.push(e);
+}
+
+void ParallelEngine::Enqueue(uint16_t core_id, Process *p, std::coroutine_handle<> handle)
+{
+    PCore *c = &core[core_id];
+    PReadyEntry entry;
+    if (algorithm == ScheduleAlgorithm::SJF)
+    {
+        entry.key = p->GetRemainingTime();
+    }
+    else if (algorithm == ScheduleAlgorithm::PP)
+    {
+        SimTime now = PartitionOf(core_id)->now;
+        entry.key = (aging_interval > 0) ? AgingKey(p->GetPriority(), now, aging_interval) : p->GetPriority();
+    }
+    else
+    {
+        entry.key = 0.0;
+    }
+    entry.seq = c->seq++;
+    entry.since = PartitionOf(core_id)->now;
+    entry.process = p;
+    entry.handle = handle;
+    c->ready.push(entry);
+    if (c->ready.size() > c->peak_ready)
+    {
+        c->peak_ready = c->ready.size();
+    }
+    if (algorithm == ScheduleAlgorithm::PP)
+    {
+        CheckPreempt(core_id, p);
+    }
+}
+
+void ParallelEngine::Dispatch(uint16_t core_id)
+{
+    PCore *c = &core[core_id];
+    if (c->ready.empty())
+    {
+        return;
+    }
+    PReadyEntry entry = c->ready.top();
+    c->ready.pop();
+    entry.process->SetEffectivePriority(AgedPriority(entry.process->GetPriority(), entry.since,
+                                                     PartitionOf(core_id)->now, aging_interval));
+    c->running = entry.process;
+    entry.handle.resume();
+}
+
+// Same rule as SimEngine, restricted to the core the process is queued on.
+void ParallelEngine::CheckPreempt(uint16_t core_id, Process *p)
+{
+    PCore *c = &core[core_id];
+    SimTime now = PartitionOf(core_id)->now;
+    if (c->running == NULL || c->preempting || c->run_end <= now ||
+        c->running->GetEffectivePriority() <= p->GetPriority())
+    {
+        return;
+    }
+    SimTime ticks = (now - c->run_start + 999) / 1000;
+    SimTime at = c->run_start + ((ticks == 0) ? 1 : ticks) * 1000;
+    if (at < c->run_end)
+    {
+        c->preempting = true;
+        c->gen++;
+        Schedule(core_id, at, EventKind::RunEnd, c->handle, 0, c->gen);
+    }
+}
+
+void ParallelEngine::HandleRunEnd(const PEvent &e)
+{
+    PCore *c = &core[e.core];
+    SimTime now = PartitionOf(e.core)->now;
+    if (e.gen != c->gen)
+    {
+        return;
+    }
+    if (c->preempting)
+    {
+        c->preempting = false;
+        if (c->ready.empty() ||
+            AgedPriority(c->ready.top().process->GetPriority(), c->ready.top().since, now, aging_interval) >=
+            c->running->GetEffectivePriority())
+        {
+            c->gen++;
+            Schedule(e.core, c->run_end, EventKind::RunEnd, c->handle, 0, c->gen);
+            return;
+        }
+    }
+    c->busy_us += now - c->run_start;
+    c->result_ms = (now - c->run_start) / 1000;
+    c->handle.resume();
+}
+
+void ParallelEngine::DelayAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    sim->Schedule(core_id, sim->PartitionOf(core_id)->now + delay, EventKind::Resume, h, id, 0);
+}
+
+bool ParallelEngine::AcquireAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    PCore *c = &sim->core[core_id];
+    if (c->running == NULL && !c->switching && c->ready.empty())
+    {
+        process->SetEffectivePriority(process->GetPriority());
+        c->running = process;
+        return false;
+    }
+    sim->Enqueue(core_id, process, h);
+    return true;
+}
+
+void ParallelEngine::RunAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    PCore *c = &sim->core[core_id];
+    SimTime now = sim->PartitionOf(core_id)->now;
+    c->running = process;
+    c->handle = h;
+    c->run_start = now;
+    c->run_end = now + (SimTime)ms * 1000;
+    c->preempting = false;
+    c->gen++;
+    sim->Schedule(core_id, c->run_end, EventKind::RunEnd, h, 0, c->gen);
+    if (sim->log_decisions)
+    {
+        DecisionRecord record;
+        record.time_us = now;
+        record.pid = process->GetPid();
+        record.core = core_id;
+        c->decisions.push_back(record);
+    }
+}
+
+void ParallelEngine::PreemptAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    PCore *c = &sim->core[core_id];
+    c->running = NULL;
+    c->switching = true;
+    c->context_switches++;
+    if (sim->algorithm == ScheduleAlgorithm::RR)
+    {
+        c->has_pending = true;
+        c->pending.process = process;
+        c->pending.handle = h;
+    }
+    else
+    {
+        sim->Enqueue(core_id, process, h);
+    }
+    sim->Schedule(core_id, sim->PartitionOf(core_id)->now + sim->context_switch, EventKind::SwitchDone, NULL, 0, 0);
+}
+
+void ParallelEngine::PlaceAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    Partition *part = sim->PartitionOf(core_id);
+    Message m;
+    m.time = part->now + sim->migration_latency;
+    m.handle = h;
+    m.id = id;
+    m.core = target;
+    part->outbox.push_back(m);
+}
+
+ParallelEngine::DelayAwaiter ParallelEngine::Delay(uint16_t core_id, uint32_t id, SimTime us)
+{
+    return DelayAwaiter{this, core_id, id, us};
+}
+
+ParallelEngine::AcquireAwaiter ParallelEngine::Acquire(uint16_t core_id, Process *p)
+{
+    return AcquireAwaiter{this, core_id, p};
+}
+
+ParallelEngine::RunAwaiter ParallelEngine::RunOn(uint16_t core_id, Process *p, uint32_t ms)
+{
+    return RunAwaiter{this, core_id, p, ms};
+}
+
+ParallelEngine::PreemptAwaiter ParallelEngine::Preempt(uint16_t core_id, Process *p)
+{
+    return PreemptAwaiter{this, core_id, p};
+}
+
+// Power of two choices over the loads captured at the last window boundary;
+// a process only leaves its core when a candidate is strictly less loaded.
+ParallelEngine::PlaceAwaiter ParallelEngine::Place(uint16_t core_id, uint32_t id, uint32_t visit)
+{
+    uint16_t target = core_id;
+    if (cores > 1)
+    {
+        uint64_t h = Mix(seed ^ ((uint64_t)id << 24) ^ visit);
+        uint16_t a = h % cores;
+        uint16_t b = (h >> 32) % cores;
+        uint16_t best = (load[a] < load[b] || (load[a] == load[b] && a < b)) ? a : b;
+        if (load[best] < load[core_id])
+        {
+            target = best;
+        }
+    }
+    return PlaceAwaiter{this, core_id, id, target};
+}
+
+void ParallelEngine::Release(uint16_t core_id, bool context_switch)
+{
+    PCore *c = &core[core_id];
+    c->running = NULL;
+    c->switching = true;
+    if (context_switch)
+    {
+        c->context_switches++;
+    }
+    Schedule(core_id, PartitionOf(core_id)->now + (context_switch ? this->context_switch : 0),
+             EventKind::SwitchDone, NULL, 0, 0);
+}
+
+void ParallelEngine::Complete(uint16_t core_id)
+{
+    Partition *part = PartitionOf(core_id);
+    part->completions.push_back(part->now);
+}
+
+uint16_t ParallelEngine::HomeCore(uint32_t id)
+{
+    return Mix(seed ^ id) % cores;
+}
+
+void ParallelEngine::Spawn(Process *p, uint32_t id)
+{
+    PartitionedLifecycle(this, p, id);
+}
+
+void ParallelEngine::ProcessWindow(uint16_t k)
+{
+    Partition *part = &partition[k];
+    while (!part->events.empty() && part->events.top().time < window_end)
+    {
+        PEvent e = part->events.top();
+        part->events.pop();
+        part->now = e.time;
+        part->events_processed++;
+        if (e.kind == EventKind::Resume)
+        {
+            e.handle.resume();
+        }
+        else if (e.kind == EventKind::RunEnd)
+        {
+            HandleRunEnd(e);
+        }
+        else
+        {
+            PCore *c = &core[e.core];
+            c->switching = false;
+            if (c->has_pending)
+            {
+                c->has_pending = false;
+                Enqueue(e.core, c->pending.process, c->pending.handle);
+            }
+            Dispatch(e.core);
+        }
+    }
+}
+
+// Between the two barriers: pull migrations addressed to this partition's
+// cores and publish its loads and next event time for the coming window.
+void ParallelEngine::Deliver(uint16_t k)
+{
+    int i, j;
+    Partition *part = &partition[k];
+    for (i = 0; i < threads; i++)
+    {
+        for (j = 0; j < partition[i].outbox.size(); j++)
+        {
+            const Message &m = partition[i].outbox[j];
+            if (m.core >= part->first_core && m.core < part->last_core)
+            {
+                core[m.core].migrations++;
+                Schedule(m.core, m.time, EventKind::Resume, m.handle, m.id, 0);
+            }
+        }
+    }
+    for (i = part->first_core; i < part->last_core; i++)
+    {
+        PCore *c = &core[i];
+        load[i] = c->ready.size() + ((c->running != NULL || c->switching || c->has_pending) ? 1 : 0);
+    }
+    part->next_time = part->events.empty() ? std::numeric_limits<SimTime>::max() : part->events.top().time;
+}
+
+// Runs on one thread once every partition has delivered.
+void ParallelEngine::EndWindow()
+{
+    int k;
+    SimTime next = std::numeric_limits<SimTime>::max();
+    for (k = 0; k < threads; k++)
+    {
+        partition[k].outbox.clear();
+        next = std::min(next, partition[k].next_time);
+    }
+    if (next == std::numeric_limits<SimTime>::max())
+    {
+        done = true;
+        return;
+    }
+    window_end = (next / lookahead + 1) * lookahead;
+    windows++;
+}
+
+// Decisions are buffered per core (each core belongs to one thread) and merged
+// by (time, core) afterwards, so the log does not depend on the thread count.
+void ParallelEngine::EnableDecisionLog()
+{
+    log_decisions = true;
+}
+
+void ParallelEngine::WriteDecisions(DecisionLog *log)
+{
+    int i;
+    std::vector<DecisionRecord> merged;
+    for (i = 0; i < cores; i++)
+    {
+        merged.insert(merged.end(), core[i].decisions.begin(), core[i].decisions.end());
+    }
+    std::stable_sort(merged.begin(), merged.end(), [](const DecisionRecord &a, const DecisionRecord &b) {
+        return a.time_us < b.time_us;
+    });
+    for (i = 0; i < merged.size(); i++)
+    {
+        log->Record(merged[i].time_us, merged[i].pid, merged[i].core);
+    }
+}
+
+// Same aging rule as SimEngine, per core run queue.
+void ParallelEngine::SetAging(uint32_t interval_ms)
+{
+    aging_interval = (SimTime)interval_ms * 1000;
+}
+
+void ParallelEngine::Run()
+{
+    int k;
+    for (k = 0; k < threads; k++)
+    {
+        Deliver(k);
+    }
+    EndWindow();
+
+    bool delivered = false;
+    auto on_phase = [this, &delivered]() noexcept {
+        if (delivered)
+        {
+            EndWindow();
+        }
+        delivered = !delivered;
+    };
+    std::barrier<decltype(on_phase)> sync(threads, on_phase);
+    auto worker = [this, &sync](uint16_t k) {
+        while (!done)
+        {
+            ProcessWindow(k);
+            sync.arrive_and_wait();
+            Deliver(k);
+            sync.arrive_and_wait();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (k = 1; k < threads; k++)
+    {
+        pool.emplace_back(worker, k);
+    }
+    worker(0);
+    for (k = 0; k < pool.size(); k++)
+    {
+        pool[k].join();
+    }
+
+    completions.clear();
+    for (k = 0; k < threads; k++)
+    {
+        completions.insert(completions.end(), partition[k].completions.begin(), partition[k].completions.end());
+    }
+    std::sort(completions.begin(), completions.end());
+}
+
+SimTime ParallelEngine::Now(uint16_t core_id)
+{
+    return PartitionOf(core_id)->now;
+}
+
+SimTime ParallelEngine::Now()
+{
+    int k;
+    SimTime latest = 0;
+    for (k = 0; k < threads; k++)
+    {
+        latest = std::max(latest, partition[k].now);
+    }
+    return latest;
+}
+
+ScheduleAlgorithm ParallelEngine::GetAlgorithm()
+{
+    return algorithm;
+}
+
+uint32_t ParallelEngine::GetTimeSlice()
+{
+    return time_slice;
+}
+
+uint16_t ParallelEngine::GetCores()
+{
+    return cores;
+}
+
+uint16_t ParallelEngine::GetThreads()
+{
+    return threads;
+}
+
+uint64_t ParallelEngine::GetWindows()
+{
+    return windows;
+}
+
+uint64_t ParallelEngine::GetEventsProcessed()
+{
+    int k;
+    uint64_t total = 0;
+    for (k = 0; k < threads; k++)
+    {
+        total += partition[k].events_processed;
+    }
+    return total;
+}
+
+uint64_t ParallelEngine::GetCoreBusy(uint16_t core_id)
+{
+    return core[core_id].busy_us;
+}
+
+uint32_t ParallelEngine::GetCoreContextSwitches(uint16_t core_id)
+{
+    return core[core_id].context_switches;
+}
+
+uint32_t ParallelEngine::GetCoreMigrations(uint16_t core_id)
+{
+    return core[core_id].migrations;
+}
+
+uint32_t ParallelEngine::GetCorePeakReady(uint16_t core_id)
+{
+    return core[core_id].peak_ready;
+}
+
+const std::vector<SimTime>& ParallelEngine::GetCompletions()
+{
+    return completions;
+}
+
+// Same lifecycle as ProcessLifecycle, except the process is tied to a core's
+// run queue and may be placed on another core after each I/O burst.
+SimTask PartitionedLifecycle(ParallelEngine *sim, Process *p, uint32_t id)
+{
+    uint64_t wait_us = 0;
+    uint32_t wait_ms = 0;
+    uint32_t visit = 0;
+    uint16_t core_id = sim->HomeCore(id);
+    SimTime ready_at;
+
+    co_await sim->Delay(core_id, id, (SimTime)p->GetStartTime() * 1000);
+    SimTime arrival = sim->Now(core_id);
+    while (true)
+    {
+        p->SetState(Process::State::Ready);
+        ready_at = sim->Now(core_id);
+        if (visit > 0)
+        {
+            uint16_t from = core_id;
+            core_id = co_await sim->Place(core_id, id, visit);
+            if (core_id != from)
+            {
+                p->CalcMigrationTime(0);
+            }
+        }
+        co_await sim->Acquire(core_id, p);
+        while (true)
+        {
+            wait_us += sim->Now(core_id) - ready_at;
+            p->CalcWaitTime(wait_us / 1000 - wait_ms);
+            wait_ms = wait_us / 1000;
+
+            p->SetState(Process::State::Running);
+            p->SetCpuCore(core_id);
+            p->CalcResponseTime((sim->Now(core_id) - arrival) / 1000);
+            uint32_t left = p->GetBurstTime() - p->GetBurstElapsed();
+            uint32_t slice = left;
+            if (sim->GetAlgorithm() == ScheduleAlgorithm::RR && sim->GetTimeSlice() < left)
+            {
+                slice = sim->GetTimeSlice();
+            }
+            uint32_t ran = co_await sim->RunOn(core_id, p, slice);
+            p->SetRemainingTime(ran);
+            p->CalcCpuTime(ran);
+            p->SetBurstElapsed(ran);
+            if (p->GetBurstElapsed() >= p->GetBurstTime())
+            {
+                break;
+            }
+
+            //slice expired or preempted by a higher priority process
+            p->UpdatePreemptions();
+            p->SetState(Process::State::Ready);
+            p->SetCpuCore(-1);
+            ready_at = sim->Now(core_id);
+            co_await sim->Preempt(core_id, p);
+        }
+        p->SetCpuCore(-1);
+        p->UpdateCurrentBurst();
+        p->SetBurstElapsed(p->GetBurstElapsed() * -1);
+        if (p->GetRemainingTime() <= 0)
+        {
+            p->SetState(Process::State::Terminated);
+            p->CalcTurnaroundTime((sim->Now(core_id) - arrival) / 1000);
+            sim->Release(core_id, false);
+            sim->Complete(core_id);
+            co_return;
+        }
+
+        p->SetState(Process::State::IO);
+        sim->Release(core_id, true);
+        co_await sim->Delay(core_id, id, (SimTime)p->GetBurstTime() * 1000);
+        p->UpdateCurrentBurst();
+        visit++;
+    }
+}
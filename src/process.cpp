@@ -1,21 +1,23 @@
 #include "process.h"
 #include "time.h"
 
-Process::Process(ProcessDetails details)
+Process::Process(const ProcessDetails &details)
 {
     int i;
     pid = details.pid;
     start_time = details.start_time;
     num_bursts = details.num_bursts;
     current_burst = 0;
-    burst_times = new uint32_t[num_bursts];
-    for (i = 0; i < num_bursts; i++)
-    {
-        burst_times[i] = details.burst_times[i];
-    }
+    burst_times = details.burst_times;
     priority = details.priority;
+    effective_priority = priority;
     state = (start_time == 0) ? Process::State::Ready : Process::State::NotStarted;
     core = -1;
+    last_core = -1;
+    migrations = 0;
+    migration_time = 0;
+    preemptions = 0;
+    response_time = -1;
     turn_time = 0;
     wait_time = 0;
     cpu_time = 0;
@@ -28,12 +30,78 @@ Process::Process(ProcessDetails details)
     process_start_time = std::chrono::high_resolution_clock::now();
 }
 
-Process::~Process()
+static uint32_t MsBefore(std::chrono::high_resolution_clock::time_point now,
+                         std::chrono::high_resolution_clock::time_point then)
+{
+    if (then >= now)
+    {
+        return 0;
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now - then).count();
+}
+
+Process::Process(const ProcessSnapshot &snapshot, const uint32_t *bursts,
+                 std::chrono::high_resolution_clock::time_point now)
 {
-    delete[] burst_times;
+    pid = snapshot.pid;
+    start_time = snapshot.start_time;
+    num_bursts = snapshot.num_bursts;
+    current_burst = snapshot.current_burst;
+    burst_times = bursts;
+    priority = snapshot.priority;
+    effective_priority = priority;
+    state = (Process::State)snapshot.state;
+    core = snapshot.core;
+    last_core = snapshot.last_core;
+    migrations = snapshot.migrations;
+    preemptions = snapshot.preemptions;
+    response_time = snapshot.response_time;
+    migration_time = snapshot.migration_time;
+    turn_time = snapshot.turn_time;
+    wait_time = snapshot.wait_time;
+    cpu_time = snapshot.cpu_time;
+    remain_time = snapshot.remain_time;
+    burst_elapsed = snapshot.burst_elapsed;
+    process_start_time = now - std::chrono::milliseconds(snapshot.since_start);
+    burst_start_time = now - std::chrono::milliseconds(snapshot.since_burst_start);
+    last_run_end = now - std::chrono::milliseconds(snapshot.since_last_run);
+    ready_queue_entry_time = now;
+    ready_since = now - std::chrono::milliseconds(snapshot.since_ready);
 }
 
-uint16_t Process::GetPid()
+void Process::Snapshot(ProcessSnapshot *snapshot, std::chrono::high_resolution_clock::time_point now)
+{
+    snapshot->pid = pid;
+    snapshot->start_time = start_time;
+    snapshot->num_bursts = num_bursts;
+    snapshot->current_burst = current_burst;
+    snapshot->burst_elapsed = burst_elapsed;
+    snapshot->since_start = MsBefore(now, process_start_time);
+    snapshot->since_burst_start = (state == Process::State::IO) ? MsBefore(now, burst_start_time) : 0;
+    snapshot->since_last_run = (last_core != -1) ? MsBefore(now, last_run_end) : 0;
+    snapshot->since_ready = (state == Process::State::Ready) ? MsBefore(now, ready_since) : 0;
+    snapshot->migrations = migrations;
+    snapshot->preemptions = preemptions;
+    snapshot->response_time = response_time;
+    snapshot->migration_time = migration_time;
+    snapshot->turn_time = turn_time;
+    snapshot->wait_time = wait_time;
+    snapshot->cpu_time = cpu_time;
+    snapshot->remain_time = remain_time;
+    snapshot->core = core;
+    snapshot->last_core = last_core;
+    snapshot->priority = priority;
+    snapshot->state = state;
+    // a core thread moves past the last burst just before it marks the
+    // process terminated; a snapshot taken in between records it as done
+    if (current_burst >= num_bursts && state != Process::State::Rejected)
+    {
+        snapshot->state = Process::State::Terminated;
+        snapshot->core = -1;
+    }
+}
+
+uint32_t Process::GetPid()
 {
     return pid;
 }
@@ -48,6 +116,18 @@ uint8_t Process::GetPriority()
     return priority;
 }
 
+// priority the process was dispatched with, which aging may have improved
+uint8_t Process::GetEffectivePriority()
+{
+    return effective_priority;
+}
+
+void Process::SetEffectivePriority(uint8_t value)
+{
+    effective_priority = value;
+    return;
+}
+
 Process::State Process::GetState()
 {
     return state;
@@ -102,23 +182,99 @@ void Process::SetReadyQueueEntryTime(std::chrono::high_resolution_clock::time_po
     return;
 }
 
-int8_t Process::GetCpuCore()
+std::chrono::high_resolution_clock::time_point Process::GetReadySince()
+{
+    return ready_since;
+}
+
+void Process::SetReadySince(std::chrono::high_resolution_clock::time_point now)
+{
+    ready_since = now;
+    return;
+}
+
+int16_t Process::GetCpuCore()
 {
     return core;
 }
 
-void Process::SetCpuCore(int8_t Core)
+void Process::SetCpuCore(int16_t Core)
 {
+    // leaving a core remembers it (and when) for the warm-cache model
+    if (Core == -1 && core != -1)
+    {
+        last_core = core;
+        last_run_end = std::chrono::high_resolution_clock::now();
+    }
     core = Core;
     return;
 }
 
+int16_t Process::GetLastCore()
+{
+    return last_core;
+}
+
+std::chrono::high_resolution_clock::time_point Process::GetLastRunEnd()
+{
+    return last_run_end;
+}
+
+uint32_t Process::GetMigrations()
+{
+    return migrations;
+}
+
+double Process::GetMigrationTime()
+{
+    return (double)migration_time / 1000000.0;
+}
+
+void Process::CalcMigrationTime(int32_t penalty_us)
+{
+    migrations = migrations + 1;
+    migration_time = migration_time + penalty_us;
+    return;
+}
+
+uint32_t Process::GetPreemptions()
+{
+    return preemptions;
+}
+
+void Process::UpdatePreemptions()
+{
+    preemptions = preemptions + 1;
+    return;
+}
+
+// -1 until the process first gets a core
+int32_t Process::GetResponseMs()
+{
+    return response_time;
+}
+
+// only the first dispatch counts
+void Process::CalcResponseTime(int32_t time_elapsed)
+{
+    if (response_time < 0)
+    {
+        response_time = time_elapsed;
+    }
+    return;
+}
+
 
 double Process::GetTurnaroundTime()
 {
     return (double)turn_time / 1000.0;
 }
 
+int32_t Process::GetTurnaroundMs()
+{
+    return turn_time;
+}
+
 void Process::CalcTurnaroundTime(int32_t time_elapsed)
 {
     turn_time = time_elapsed;
@@ -130,6 +286,11 @@ double Process::GetWaitTime()
     return (double)wait_time / 1000.0;
 }
 
+int32_t Process::GetWaitMs()
+{
+    return wait_time;
+}
+
 void Process::CalcWaitTime(int32_t time_elapsed)
 {
     wait_time = wait_time + time_elapsed;
@@ -141,6 +302,11 @@ double Process::GetCpuTime()
     return (double)cpu_time / 1000.0;
 }
 
+int32_t Process::GetCpuMs()
+{
+    return cpu_time;
+}
+
 void Process::CalcCpuTime(int32_t time_elapsed)
 {
     cpu_time = cpu_time + time_elapsed;
@@ -167,3 +333,54 @@ void Process::SetBurstElapsed(uint32_t time_elapsed)
 {
     burst_elapsed = burst_elapsed + time_elapsed;
 }
+
+void ProcessTable::Index()
+{
+    size_t i;
+    processes.resize(storage.size());
+    for (i = 0; i < storage.size(); i++)
+    {
+        processes[i] = &storage[i];
+    }
+}
+
+// Rebuilding reuses the storage already reserved, so repeated runs over the
+// same configuration allocate nothing.
+void ProcessTable::Create(const SchedulerConfig &config)
+{
+    uint32_t i;
+    bursts = config.bursts;
+    storage.clear();
+    storage.reserve(config.num_processes);
+    for (i = 0; i < config.num_processes; i++)
+    {
+        storage.emplace_back(config.processes[i]);
+    }
+    Index();
+}
+
+void ProcessTable::Restore(const std::vector<ProcessSnapshot> &snapshots, const BurstPool &bursts,
+                           std::chrono::high_resolution_clock::time_point now)
+{
+    size_t i;
+    uint32_t offset = 0;
+    this->bursts = bursts;
+    storage.clear();
+    storage.reserve(snapshots.size());
+    for (i = 0; i < snapshots.size(); i++)
+    {
+        storage.emplace_back(snapshots[i], bursts->data() + offset, now);
+        offset += snapshots[i].num_bursts;
+    }
+    Index();
+}
+
+std::vector<Process*>& ProcessTable::GetProcesses()
+{
+    return processes;
+}
+
+const BurstPool& ProcessTable::GetBursts()
+{
+    return bursts;
+}
@@ -0,0 +1,187 @@
+#include "profiler.h"
+
+#ifdef SCHED_PROFILE
+
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+typedef struct alignas(64) ProfileSlot {
+    Histogram lock_wait;
+    Histogram lock_hold;
+    Histogram dispatch;
+    uint64_t idle_spins;
+    std::chrono::high_resolution_clock::time_point acquired;
+} ProfileSlot;
+
+static uint16_t profileCores = 0;
+static ProfileSlot *profileSlots = NULL;
+static Histogram scanHistogram;
+
+static uint64_t ElapsedNs(std::chrono::high_resolution_clock::time_point from,
+                          std::chrono::high_resolution_clock::time_point to)
+{
+    if (to <= from)
+    {
+        return 0;
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+// bucket i holds samples in [2^i, 2^(i+1)) ns; bucket 0 also holds 0
+static void HistogramAdd(Histogram *h, uint64_t ns)
+{
+    int bucket = 0;
+    uint64_t v = ns;
+    while (v > 1 && bucket < PROFILE_BUCKETS - 1)
+    {
+        v >>= 1;
+        bucket++;
+    }
+    h->buckets[bucket]++;
+    h->count++;
+    h->total_ns += ns;
+    if (ns > h->max_ns)
+    {
+        h->max_ns = ns;
+    }
+}
+
+static void HistogramMerge(Histogram *into, const Histogram *from)
+{
+    int i;
+    for (i = 0; i < PROFILE_BUCKETS; i++)
+    {
+        into->buckets[i] += from->buckets[i];
+    }
+    into->count += from->count;
+    into->total_ns += from->total_ns;
+    if (from->max_ns > into->max_ns)
+    {
+        into->max_ns = from->max_ns;
+    }
+}
+
+// upper bound of the bucket containing the requested percentile
+static uint64_t HistogramPercentile(const Histogram *h, double pct)
+{
+    int i;
+    uint64_t seen = 0;
+    uint64_t target = (uint64_t)(pct * h->count);
+    for (i = 0; i < PROFILE_BUCKETS; i++)
+    {
+        seen += h->buckets[i];
+        if (seen > target)
+        {
+            uint64_t bound = (uint64_t)2 << i;
+            return (bound < h->max_ns) ? bound : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
+static void PrintHistogram(std::ostream &out, const char *label, const Histogram *h)
+{
+    char line[160];
+    double mean = (h->count == 0) ? 0.0 : (double)h->total_ns / h->count / 1000.0;
+    snprintf(line, sizeof(line), "  %-22s %10llu samples  mean %10.3f us  p50 <%10.3f us  p99 <%10.3f us  max %10.3f us\n",
+             label, (unsigned long long)h->count, mean, HistogramPercentile(h, 0.50) / 1000.0,
+             HistogramPercentile(h, 0.99) / 1000.0, h->max_ns / 1000.0);
+    out << line;
+}
+
+// Over-aligned new needs C++17, so the slots are allocated on a cache line
+// boundary by hand and constructed in place.
+void ProfilerInit(uint16_t cores)
+{
+    int i;
+    void *memory = NULL;
+    profileCores = cores;
+    if (posix_memalign(&memory, alignof(ProfileSlot), sizeof(ProfileSlot) * (cores + 1)) != 0)
+    {
+        throw std::bad_alloc();
+    }
+    profileSlots = (ProfileSlot*)memory;
+    for (i = 0; i <= cores; i++)
+    {
+        new (&profileSlots[i]) ProfileSlot();
+    }
+    memset(&scanHistogram, 0, sizeof(Histogram));
+}
+
+void ProfileLock(std::mutex *mutex, uint16_t slot)
+{
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    mutex->lock();
+    profileSlots[slot].acquired = std::chrono::high_resolution_clock::now();
+    HistogramAdd(&profileSlots[slot].lock_wait, ElapsedNs(start, profileSlots[slot].acquired));
+}
+
+void ProfileUnlock(std::mutex *mutex, uint16_t slot)
+{
+    std::chrono::high_resolution_clock::time_point released = std::chrono::high_resolution_clock::now();
+    mutex->unlock();
+    HistogramAdd(&profileSlots[slot].lock_hold, ElapsedNs(profileSlots[slot].acquired, released));
+}
+
+void ProfileIdleSpin(uint16_t slot)
+{
+    profileSlots[slot].idle_spins++;
+}
+
+void ProfileDispatch(uint16_t slot, std::chrono::high_resolution_clock::time_point ready_since)
+{
+    HistogramAdd(&profileSlots[slot].dispatch, ElapsedNs(ready_since, std::chrono::high_resolution_clock::now()));
+}
+
+void ProfileScan(std::chrono::high_resolution_clock::time_point scan_start)
+{
+    HistogramAdd(&scanHistogram, ElapsedNs(scan_start, std::chrono::high_resolution_clock::now()));
+}
+
+void ProfilerPrint(std::ostream &out)
+{
+    int i;
+    char label[32];
+    Histogram wait, hold, dispatch;
+    memset(&wait, 0, sizeof(Histogram));
+    memset(&hold, 0, sizeof(Histogram));
+    memset(&dispatch, 0, sizeof(Histogram));
+    for (i = 0; i < profileCores; i++)
+    {
+        HistogramMerge(&wait, &profileSlots[i].lock_wait);
+        HistogramMerge(&hold, &profileSlots[i].lock_hold);
+        HistogramMerge(&dispatch, &profileSlots[i].dispatch);
+    }
+
+    out << "Profile:\n";
+    out << " Ready queue lock (scheduling threads)\n";
+    PrintHistogram(out, "wait", &wait);
+    PrintHistogram(out, "hold", &hold);
+    out << " Ready queue lock (main thread)\n";
+    PrintHistogram(out, "wait", &profileSlots[profileCores].lock_wait);
+    PrintHistogram(out, "hold", &profileSlots[profileCores].lock_hold);
+    out << " Dispatch latency (ready -> running)\n";
+    PrintHistogram(out, "all cores", &dispatch);
+    out << " Main thread scan\n";
+    PrintHistogram(out, "per scan", &scanHistogram);
+    out << " Per core\n";
+    for (i = 0; i < profileCores; i++)
+    {
+        snprintf(label, sizeof(label), "core %d dispatch", i);
+        PrintHistogram(out, label, &profileSlots[i].dispatch);
+        snprintf(label, sizeof(label), "core %d lock wait", i);
+        PrintHistogram(out, label, &profileSlots[i].lock_wait);
+        out << "  core " << i << " idle spins        " << profileSlots[i].idle_spins << "\n";
+    }
+}
+
+void ProfilerDelete()
+{
+    // slots are plain data, so there is nothing to destroy before freeing
+    free(profileSlots);
+    profileSlots = NULL;
+}
+
+#endif // SCHED_PROFILE
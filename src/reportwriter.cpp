@@ -0,0 +1,331 @@
+#include "reportwriter.h"
+#include <cmath>
+#include <cstring>
+
+ReportWriter::ReportWriter(FILE *out, size_t capacity)
+{
+    this->out = out;
+    this->capacity = (capacity < 64) ? 64 : capacity;
+    buffer = new char[this->capacity];
+    used = 0;
+}
+
+ReportWriter::~ReportWriter()
+{
+    Flush();
+    delete[] buffer;
+}
+
+void ReportWriter::Reserve(size_t n)
+{
+    if (used + n > capacity)
+    {
+        Flush();
+    }
+}
+
+void ReportWriter::Flush()
+{
+    if (used > 0)
+    {
+        fwrite(buffer, 1, used, out);
+        used = 0;
+    }
+}
+
+void ReportWriter::PutChar(char c)
+{
+    Reserve(1);
+    buffer[used++] = c;
+}
+
+void ReportWriter::PutString(const char *s)
+{
+    size_t len = strlen(s);
+    if (len > capacity)
+    {
+        Flush();
+        fwrite(s, 1, len, out);
+        return;
+    }
+    Reserve(len);
+    memcpy(buffer + used, s, len);
+    used += len;
+}
+
+// digits are produced backwards into a scratch array, then copied
+void ReportWriter::PutUInt(uint64_t value)
+{
+    char digits[20];
+    int n = 0;
+    do
+    {
+        digits[n++] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+    Reserve(n);
+    while (n > 0)
+    {
+        buffer[used++] = digits[--n];
+    }
+}
+
+void ReportWriter::PutInt(int64_t value)
+{
+    if (value < 0)
+    {
+        PutChar('-');
+        PutUInt(-(uint64_t)value);
+        return;
+    }
+    PutUInt(value);
+}
+
+// milliseconds as seconds with three decimals, without going through a double
+void ReportWriter::PutMillis(int64_t ms)
+{
+    uint64_t magnitude = (ms < 0) ? -(uint64_t)ms : ms;
+    uint32_t frac = magnitude % 1000;
+    if (ms < 0)
+    {
+        PutChar('-');
+    }
+    PutUInt(magnitude / 1000);
+    Reserve(4);
+    buffer[used++] = '.';
+    buffer[used++] = '0' + frac / 100;
+    buffer[used++] = '0' + (frac / 10) % 10;
+    buffer[used++] = '0' + frac % 10;
+}
+
+// Values whose scaled form does not fit a 64-bit integer (including inf and
+// nan) fall back to printf formatting.
+void ReportWriter::PutFixed(double value, int decimals)
+{
+    int i;
+    uint64_t scale = 1;
+    for (i = 0; i < decimals; i++)
+    {
+        scale *= 10;
+    }
+    if (!std::isfinite(value) || std::fabs(value) * scale >= 9.0e18)
+    {
+        char text[512];
+        snprintf(text, sizeof(text), "%.*f", decimals, value);
+        PutString(text);
+        return;
+    }
+    if (value < 0)
+    {
+        PutChar('-');
+        value = -value;
+    }
+    uint64_t scaled = (uint64_t)std::llround(value * scale);
+    PutUInt(scaled / scale);
+    if (decimals > 0)
+    {
+        uint64_t frac = scaled % scale;
+        Reserve(decimals + 1);
+        buffer[used++] = '.';
+        for (i = decimals - 1; i >= 0; i--)
+        {
+            buffer[used + i] = '0' + (frac % 10);
+            frac /= 10;
+        }
+        used += decimals;
+    }
+}
+
+bool ParseReportFormat(const char *name, ReportWriter::Format *format)
+{
+    if (strcmp(name, "csv") == 0)
+    {
+        *format = ReportWriter::Format::CSV;
+        return true;
+    }
+    if (strcmp(name, "json") == 0)
+    {
+        *format = ReportWriter::Format::JSON;
+        return true;
+    }
+    return false;
+}
+
+// Non-finite values (e.g. a throughput over zero time) have no CSV or JSON
+// number form, so they are left empty / written as null.
+static void PutValue(ReportWriter *writer, ReportWriter::Format format, double value)
+{
+    if (!std::isfinite(value))
+    {
+        if (format == ReportWriter::Format::JSON)
+        {
+            writer->PutString("null");
+        }
+        return;
+    }
+    writer->PutFixed(value, 6);
+}
+
+static void PutResponse(ReportWriter *writer, ReportWriter::Format format, int32_t ms)
+{
+    if (ms < 0)
+    {
+        if (format == ReportWriter::Format::JSON)
+        {
+            writer->PutString("null");
+        }
+        return;
+    }
+    writer->PutMillis(ms);
+}
+
+void WriteReport(FILE *out, ReportWriter::Format format, const std::vector<Process*> &processes,
+                 const ReportSummary &summary)
+{
+    size_t i;
+    uint64_t preemptions = 0;
+    uint64_t migrations = 0;
+    uint64_t rows = 0;
+    ReportWriter writer(out, 1 << 20);
+    bool json = (format == ReportWriter::Format::JSON);
+
+    if (json)
+    {
+        writer.PutString("{\"processes\": [\n");
+    }
+    else
+    {
+        writer.PutString("pid,priority,turnaround,wait,cpu,response,preemptions,migrations\n");
+    }
+    for (i = 0; i < processes.size(); i++)
+    {
+        Process *p = processes[i];
+        if (p->GetState() == Process::State::Rejected)
+        {
+            continue;
+        }
+        preemptions += p->GetPreemptions();
+        migrations += p->GetMigrations();
+        if (json)
+        {
+            writer.PutString((rows++ == 0) ? "  {\"pid\": " : ",\n  {\"pid\": ");
+            writer.PutUInt(p->GetPid());
+            writer.PutString(", \"priority\": ");
+            writer.PutUInt(p->GetPriority());
+            writer.PutString(", \"turnaround\": ");
+            writer.PutMillis(p->GetTurnaroundMs());
+            writer.PutString(", \"wait\": ");
+            writer.PutMillis(p->GetWaitMs());
+            writer.PutString(", \"cpu\": ");
+            writer.PutMillis(p->GetCpuMs());
+            writer.PutString(", \"response\": ");
+            PutResponse(&writer, format, p->GetResponseMs());
+            writer.PutString(", \"preemptions\": ");
+            writer.PutUInt(p->GetPreemptions());
+            writer.PutString(", \"migrations\": ");
+            writer.PutUInt(p->GetMigrations());
+            writer.PutChar('}');
+        }
+        else
+        {
+            writer.PutUInt(p->GetPid());
+            writer.PutChar(',');
+            writer.PutUInt(p->GetPriority());
+            writer.PutChar(',');
+            writer.PutMillis(p->GetTurnaroundMs());
+            writer.PutChar(',');
+            writer.PutMillis(p->GetWaitMs());
+            writer.PutChar(',');
+            writer.PutMillis(p->GetCpuMs());
+            writer.PutChar(',');
+            PutResponse(&writer, format, p->GetResponseMs());
+            writer.PutChar(',');
+            writer.PutUInt(p->GetPreemptions());
+            writer.PutChar(',');
+            writer.PutUInt(p->GetMigrations());
+            writer.PutChar('\n');
+        }
+    }
+
+    const char *names[] = {"processes", "elapsed_time", "cpu_utilization", "throughput_first_half",
+                           "throughput_second_half", "throughput", "avg_turnaround", "avg_wait",
+                           "avg_response", "context_switches", "preemptions", "migrations", "deferred",
+                           "rejected", "peak_ready"};
+    const double values[] = {summary.elapsed_time, summary.cpu_utilization, summary.throughput_first_half,
+                             summary.throughput_second_half, summary.throughput, summary.avg_turnaround,
+                             summary.avg_wait, summary.avg_response};
+    const uint64_t counts[] = {summary.context_switches, preemptions, migrations, summary.deferred,
+                               summary.rejected, summary.peak_ready};
+    const size_t num_values = sizeof(values) / sizeof(values[0]);
+    const size_t num_counts = sizeof(counts) / sizeof(counts[0]);
+    if (json)
+    {
+        writer.PutString("\n],\n\"summary\": {\"processes\": ");
+        writer.PutUInt(processes.size());
+        for (i = 0; i < num_values; i++)
+        {
+            writer.PutString(", \"");
+            writer.PutString(names[i + 1]);
+            writer.PutString("\": ");
+            PutValue(&writer, format, values[i]);
+        }
+        for (i = 0; i < num_counts; i++)
+        {
+            writer.PutString(", \"");
+            writer.PutString(names[i + 1 + num_values]);
+            writer.PutString("\": ");
+            writer.PutUInt(counts[i]);
+        }
+        writer.PutString(", \"core_types\": [");
+        for (i = 0; i < summary.core_types.size(); i++)
+        {
+            writer.PutString((i == 0) ? "{\"speed\": " : ", {\"speed\": ");
+            PutValue(&writer, format, summary.core_types[i].speed);
+            writer.PutString(", \"cores\": ");
+            writer.PutUInt(summary.core_types[i].cores);
+            writer.PutString(", \"utilization\": ");
+            PutValue(&writer, format, summary.core_types[i].utilization);
+            writer.PutChar('}');
+        }
+        writer.PutString("]}}\n");
+    }
+    else
+    {
+        writer.PutChar('\n');
+        for (i = 0; i < 1 + num_values + num_counts; i++)
+        {
+            if (i > 0)
+            {
+                writer.PutChar(',');
+            }
+            writer.PutString(names[i]);
+        }
+        writer.PutChar('\n');
+        writer.PutUInt(processes.size());
+        for (i = 0; i < num_values; i++)
+        {
+            writer.PutChar(',');
+            PutValue(&writer, format, values[i]);
+        }
+        for (i = 0; i < num_counts; i++)
+        {
+            writer.PutChar(',');
+            writer.PutUInt(counts[i]);
+        }
+        writer.PutChar('\n');
+        if (!summary.core_types.empty())
+        {
+            writer.PutString("\nspeed,cores,utilization\n");
+            for (i = 0; i < summary.core_types.size(); i++)
+            {
+                PutValue(&writer, format, summary.core_types[i].speed);
+                writer.PutChar(',');
+                writer.PutUInt(summary.core_types[i].cores);
+                writer.PutChar(',');
+                PutValue(&writer, format, summary.core_types[i].utilization);
+                writer.PutChar('\n');
+            }
+        }
+    }
+    writer.Flush();
+}
@@ -0,0 +1,160 @@
+#include "shmmetrics.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static ShmMetrics* MapMetrics(const char *name, int flags)
+{
+    int fd = shm_open(name, flags, 0644);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if ((flags & O_CREAT) && ftruncate(fd, sizeof(ShmMetrics)) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    // a reader can open the segment before the writer has sized it; mapping
+    // it then would fault on the first read
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ShmMetrics))
+    {
+        close(fd);
+        return NULL;
+    }
+    int prot = ((flags & O_ACCMODE) == O_RDONLY) ? PROT_READ : PROT_READ | PROT_WRITE;
+    void *addr = mmap(NULL, sizeof(ShmMetrics), prot, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return NULL;
+    }
+    return (ShmMetrics*)addr;
+}
+
+// The segment has a fixed number of core slots; larger machines are refused.
+// A segment left behind by a run that did not exit cleanly is unlinked and
+// a fresh one created exclusively, so an old mapping is never reused.
+ShmMetrics* ShmMetricsCreate(const char *name, uint16_t cores)
+{
+    int i;
+    if (cores > SHM_METRICS_MAX_CORES)
+    {
+        return NULL;
+    }
+    shm_unlink(name);
+    ShmMetrics *metrics = MapMetrics(name, O_CREAT | O_EXCL | O_RDWR);
+    if (metrics == NULL)
+    {
+        return NULL;
+    }
+    memset((void*)metrics, 0, sizeof(ShmMetrics));
+    metrics->cores = cores;
+    metrics->version = SHM_METRICS_VERSION;
+    for (i = 0; i < metrics->cores; i++)
+    {
+        metrics->core[i].data.pid = -1;
+    }
+    // magic is written last so readers never see a half-initialised segment
+    std::atomic_thread_fence(std::memory_order_release);
+    metrics->magic = SHM_METRICS_MAGIC;
+    return metrics;
+}
+
+ShmMetrics* ShmMetricsOpen(const char *name)
+{
+    ShmMetrics *metrics = MapMetrics(name, O_RDONLY);
+    if (metrics == NULL)
+    {
+        return NULL;
+    }
+    if (metrics->magic != SHM_METRICS_MAGIC || metrics->version != SHM_METRICS_VERSION)
+    {
+        ShmMetricsClose(metrics);
+        return NULL;
+    }
+    return metrics;
+}
+
+void ShmMetricsClose(ShmMetrics *metrics)
+{
+    munmap((void*)metrics, sizeof(ShmMetrics));
+}
+
+void ShmMetricsUnlink(const char *name)
+{
+    shm_unlink(name);
+}
+
+void ShmPublishCore(ShmMetrics *metrics, uint16_t core_id, const ShmCoreData &data)
+{
+    if (core_id >= metrics->cores)
+    {
+        return;
+    }
+    ShmCoreSlot *slot = &metrics->core[core_id];
+    uint32_t seq = slot->seq.load(std::memory_order_relaxed);
+    slot->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->data = data;
+    slot->seq.store(seq + 2, std::memory_order_release);
+}
+
+void ShmPublishSummary(ShmMetrics *metrics, const ShmSummaryData &data)
+{
+    ShmSummarySlot *slot = &metrics->summary;
+    uint32_t seq = slot->seq.load(std::memory_order_relaxed);
+    slot->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->data = data;
+    slot->seq.store(seq + 2, std::memory_order_release);
+}
+
+void ShmReadCore(ShmMetrics *metrics, uint16_t core_id, ShmCoreData *data)
+{
+    if (core_id >= metrics->cores || core_id >= SHM_METRICS_MAX_CORES)
+    {
+        memset(data, 0, sizeof(ShmCoreData));
+        data->pid = -1;
+        return;
+    }
+    ShmCoreSlot *slot = &metrics->core[core_id];
+    uint32_t before, after;
+    do
+    {
+        before = slot->seq.load(std::memory_order_acquire);
+        memcpy(data, &slot->data, sizeof(ShmCoreData));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = slot->seq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+void ShmReadSummary(ShmMetrics *metrics, ShmSummaryData *data)
+{
+    ShmSummarySlot *slot = &metrics->summary;
+    uint32_t before, after;
+    do
+    {
+        before = slot->seq.load(std::memory_order_acquire);
+        memcpy(data, &slot->data, sizeof(ShmSummaryData));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = slot->seq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+// Sum of every slot's sequence counter. Scheduling threads publish about once
+// a millisecond even when idle, so this only stops moving once the writer has
+// stopped.
+uint64_t ShmHeartbeat(ShmMetrics *metrics)
+{
+    int i;
+    uint64_t beat = metrics->summary.seq.load(std::memory_order_relaxed);
+    for (i = 0; i < metrics->cores && i < SHM_METRICS_MAX_CORES; i++)
+    {
+        beat += metrics->core[i].seq.load(std::memory_order_relaxed);
+    }
+    return beat;
+}
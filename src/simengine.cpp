@@ -0,0 +1,612 @@
+#include "simengine.h"
+#include <algorithm>
+#include <cmath>
+
+SimEngine::SimEngine(uint16_t cores, ScheduleAlgorithm algorithm, uint32_t context_switch, uint32_t time_slice)
+    : idle(IdleLater{&idle_rank})
+{
+    int i;
+    this->cores = cores;
+    this->algorithm = algorithm;
+    this->context_switch = context_switch;
+    this->time_slice = time_slice;
+    now = 0;
+    next_seq = 0;
+    events_processed = 0;
+    decision_log = NULL;
+    aging_interval = 0;
+    max_ready = 0;
+    reject = false;
+    deferred = 0;
+    rejected = 0;
+    admitted = 0;
+    peak_ready = 0;
+    speed.assign(cores, 1.0);
+    speed_scaled = false;
+    fastest = 1.0;
+    placement = Placement::Any;
+    window = 1;
+    idle_rank.assign(cores, 0.0);
+    core.resize(cores);
+    for (i = 0; i < cores; i++)
+    {
+        core[i].running = NULL;
+        core[i].run_start = 0;
+        core[i].run_end = 0;
+        core[i].run_ms = 0;
+        core[i].result_ms = 0;
+        core[i].gen = 0;
+        core[i].preempting = false;
+        core[i].has_pending = false;
+        core[i].busy_us = 0;
+        core[i].context_switches = 0;
+        idle.push(i);
+    }
+}
+
+void SimEngine::Schedule(SimTime time, EventKind kind, std::coroutine_handle<> handle, uint16_t core_id, uint32_t gen)
+{
+    SimEvent e;
+    e.time = time;
+    e.seq = next_seq++;
+    e.handle = handle;
+    e.gen = gen;
+    e.core = core_id;
+    e.kind = kind;
+    events.push(e);
+}
+
+// Ready queue order matches the threaded engine's inserts: FIFO for FCFS/RR,
+// remaining time for SJF and priority (or its aging key) for PP, first come
+// first served on ties.
+void SimEngine::Enqueue(Process *p, std::coroutine_handle<> handle, uint16_t *assigned)
+{
+    ReadyEntry entry;
+    if (algorithm == ScheduleAlgorithm::SJF)
+    {
+        entry.key = p->GetRemainingTime();
+    }
+    else if (algorithm == ScheduleAlgorithm::PP)
+    {
+        entry.key = (aging_interval > 0) ? AgingKey(p->GetPriority(), now, aging_interval) : p->GetPriority();
+    }
+    else
+    {
+        entry.key = 0.0;
+    }
+    entry.seq = next_seq++;
+    entry.since = now;
+    entry.process = p;
+    entry.handle = handle;
+    entry.assigned = assigned;
+    ready.push(entry);
+    if (ready.size() > peak_ready)
+    {
+        peak_ready = ready.size();
+    }
+    if (algorithm == ScheduleAlgorithm::PP)
+    {
+        CheckPreempt(p);
+    }
+}
+
+// With speed-aware placement a core slower than the fastest takes the entry
+// with the least work left among the first `window` in queue order (only
+// those tied with the front under PP), as the threaded engine's PickProcess
+// does; the rest go back with their original sequence numbers.
+bool SimEngine::PopForCore(uint16_t core_id, ReadyEntry *entry)
+{
+    size_t i;
+    size_t pick = 0;
+    if (ready.empty())
+    {
+        return false;
+    }
+    if (placement != Placement::Speed || speed[core_id] >= fastest)
+    {
+        *entry = ready.top();
+        ready.pop();
+        return true;
+    }
+    uint8_t front_priority = AgedPriority(ready.top().process->GetPriority(), ready.top().since, now, aging_interval);
+    scan.clear();
+    while (!ready.empty() && scan.size() < window)
+    {
+        const ReadyEntry &top = ready.top();
+        if (algorithm == ScheduleAlgorithm::PP &&
+            AgedPriority(top.process->GetPriority(), top.since, now, aging_interval) != front_priority)
+        {
+            break;
+        }
+        scan.push_back(top);
+        ready.pop();
+    }
+    for (i = 1; i < scan.size(); i++)
+    {
+        if (scan[i].process->GetRemainingTime() < scan[pick].process->GetRemainingTime())
+        {
+            pick = i;
+        }
+    }
+    *entry = scan[pick];
+    for (i = 0; i < scan.size(); i++)
+    {
+        if (i != pick)
+        {
+            ready.push(scan[i]);
+        }
+    }
+    return true;
+}
+
+void SimEngine::Dispatch(uint16_t core_id)
+{
+    ReadyEntry entry;
+    if (!PopForCore(core_id, &entry))
+    {
+        idle.push(core_id);
+        return;
+    }
+    entry.process->SetEffectivePriority(AgedPriority(entry.process->GetPriority(), entry.since, now, aging_interval));
+    core[core_id].running = entry.process;
+    *entry.assigned = core_id;
+    entry.handle.resume();
+}
+
+// Preempt the running process with the worst priority if p beats it. Like the
+// threaded engine, which checks once per 1 ms tick, preemption lands on the
+// next whole millisecond of the victim's run.
+void SimEngine::CheckPreempt(Process *p)
+{
+    int i;
+    int victim = -1;
+    for (i = 0; i < cores; i++)
+    {
+        if (core[i].running == NULL || core[i].preempting || core[i].run_end <= now)
+        {
+            continue;
+        }
+        if (core[i].running->GetEffectivePriority() > p->GetPriority() &&
+            (victim < 0 || core[i].running->GetEffectivePriority() > core[victim].running->GetEffectivePriority()))
+        {
+            victim = i;
+        }
+    }
+    if (victim < 0)
+    {
+        return;
+    }
+    SimCore *c = &core[victim];
+    SimTime ticks = (now - c->run_start + 999) / 1000;
+    SimTime at = c->run_start + ((ticks == 0) ? 1 : ticks) * 1000;
+    if (at < c->run_end)
+    {
+        c->preempting = true;
+        c->gen++;
+        Schedule(at, EventKind::RunEnd, c->handle, victim, c->gen);
+    }
+}
+
+void SimEngine::HandleRunEnd(const SimEvent &e)
+{
+    SimCore *c = &core[e.core];
+    if (e.gen != c->gen)
+    {
+        return;
+    }
+    if (c->preempting)
+    {
+        c->preempting = false;
+        // the process that triggered the preemption may already be running elsewhere
+        if (ready.empty() || AgedPriority(ready.top().process->GetPriority(), ready.top().since, now, aging_interval) >=
+                             c->running->GetEffectivePriority())
+        {
+            c->gen++;
+            Schedule(c->run_end, EventKind::RunEnd, c->handle, e.core, c->gen);
+            return;
+        }
+    }
+    c->busy_us += now - c->run_start;
+    c->result_ms = (now >= c->run_end) ? c->run_ms : Work(e.core, now - c->run_start);
+    c->handle.resume();
+}
+
+// Deferred arrivals are let in, oldest first, as terminations make room.
+// A resumed arrival either queues or takes an idle core before returning.
+void SimEngine::AdmitBacklog()
+{
+    while (!backlog.empty() && admitted < max_ready)
+    {
+        admitted++;
+        std::coroutine_handle<> h = backlog.front();
+        backlog.pop_front();
+        h.resume();
+    }
+}
+
+// Same rule as the threaded engine: an arrival gets in while the processes
+// admitted and not yet terminated are below max_ready and nobody is waiting in
+// the backlog ahead of it.
+bool SimEngine::AdmitAwaiter::await_ready()
+{
+    if (sim->max_ready == 0 || (sim->backlog.empty() && sim->admitted < sim->max_ready))
+    {
+        sim->admitted++;
+        admitted = true;
+        return true;
+    }
+    if (sim->reject)
+    {
+        sim->rejected++;
+        admitted = false;
+        return true;
+    }
+    return false;
+}
+
+void SimEngine::AdmitAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    process->SetState(Process::State::Deferred);
+    sim->deferred++;
+    admitted = true;
+    sim->backlog.push_back(h);
+}
+
+void SimEngine::DelayAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    sim->Schedule(sim->now + delay, EventKind::Resume, h, 0, 0);
+}
+
+bool SimEngine::AcquireAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    if (!sim->idle.empty())
+    {
+        assigned = sim->idle.top();
+        sim->idle.pop();
+        process->SetEffectivePriority(process->GetPriority());
+        sim->core[assigned].running = process;
+        return false;
+    }
+    sim->Enqueue(process, h, &assigned);
+    return true;
+}
+
+void SimEngine::RunAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    SimCore *c = &sim->core[core_id];
+    c->running = process;
+    c->handle = h;
+    c->run_start = sim->now;
+    c->run_end = sim->now + sim->RunTime(core_id, ms);
+    c->run_ms = ms;
+    c->preempting = false;
+    c->gen++;
+    sim->Schedule(c->run_end, EventKind::RunEnd, h, core_id, c->gen);
+    if (sim->decision_log != NULL)
+    {
+        sim->decision_log->Record(sim->now, process->GetPid(), core_id);
+    }
+}
+
+// RR puts the process at the back of the queue after the context switch; PP
+// reinserts it straight away so the switching core picks the new front.
+void SimEngine::PreemptAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    SimCore *c = &sim->core[core_id];
+    c->running = NULL;
+    c->context_switches++;
+    if (sim->algorithm == ScheduleAlgorithm::RR)
+    {
+        c->has_pending = true;
+        c->pending.process = process;
+        c->pending.handle = h;
+        c->pending.assigned = &assigned;
+    }
+    else
+    {
+        sim->Enqueue(process, h, &assigned);
+    }
+    sim->Schedule(sim->now + sim->context_switch, EventKind::SwitchDone, NULL, core_id, 0);
+}
+
+SimEngine::DelayAwaiter SimEngine::Delay(SimTime us)
+{
+    return DelayAwaiter{this, us};
+}
+
+SimEngine::AdmitAwaiter SimEngine::Admit(Process *p)
+{
+    return AdmitAwaiter{this, p, false};
+}
+
+SimEngine::AcquireAwaiter SimEngine::Acquire(Process *p)
+{
+    return AcquireAwaiter{this, p, 0};
+}
+
+SimEngine::RunAwaiter SimEngine::RunOn(Process *p, uint16_t core_id, uint32_t ms)
+{
+    return RunAwaiter{this, p, core_id, ms};
+}
+
+SimEngine::PreemptAwaiter SimEngine::Preempt(Process *p, uint16_t core_id)
+{
+    return PreemptAwaiter{this, p, core_id, 0};
+}
+
+void SimEngine::Release(uint16_t core_id, bool context_switch)
+{
+    core[core_id].running = NULL;
+    if (context_switch)
+    {
+        core[core_id].context_switches++;
+    }
+    Schedule(now + (context_switch ? this->context_switch : 0), EventKind::SwitchDone, NULL, core_id, 0);
+}
+
+void SimEngine::Complete()
+{
+    completions.push_back(now);
+    admitted--;
+}
+
+void SimEngine::Spawn(Process *p)
+{
+    ProcessLifecycle(this, p);
+}
+
+// Every run started on a core is recorded, in event order.
+void SimEngine::SetDecisionLog(DecisionLog *log)
+{
+    decision_log = log;
+}
+
+// PP aging (see aging.h); preemption is still only checked on arrival and at
+// the end of a run, so aging reorders the queue but does not preempt on its own.
+void SimEngine::SetAging(uint32_t interval_ms)
+{
+    aging_interval = (SimTime)interval_ms * 1000;
+}
+
+// Bounded population (max_ready 0 is unbounded): at most max_ready processes
+// are admitted and not yet terminated, so the ready queue never holds more.
+// Arrivals over the bound wait in a backlog, or are turned away with reject.
+void SimEngine::SetAdmission(uint32_t max_ready, bool reject)
+{
+    this->max_ready = max_ready;
+    this->reject = reject;
+}
+
+// Per-core speed factors scale how fast bursts progress: a run of ms of work
+// takes ms / speed of simulated time. With Speed placement, arrivals take the
+// fastest idle core and slower cores take the shortest work (PopForCore);
+// window is the number of queue entries a slow core looks at.
+void SimEngine::SetCoreSpeeds(const std::vector<double> &speeds, Placement placement, uint16_t window)
+{
+    int i;
+    this->placement = placement;
+    this->window = (window < 1) ? 1 : window;
+    if (!speeds.empty())
+    {
+        speed = speeds;
+        speed_scaled = true;
+    }
+    fastest = *std::max_element(speed.begin(), speed.end());
+    if (placement == Placement::Speed)
+    {
+        idle_rank = speed;
+    }
+    // all cores are still idle; rebuild the heap under the new ranking
+    idle = std::priority_queue<uint16_t, std::vector<uint16_t>, IdleLater>(IdleLater{&idle_rank});
+    for (i = 0; i < cores; i++)
+    {
+        idle.push(i);
+    }
+}
+
+// Simulated time for ms of work on core_id, rounded up to a whole microsecond.
+SimTime SimEngine::RunTime(uint16_t core_id, uint32_t ms)
+{
+    if (!speed_scaled)
+    {
+        return (SimTime)ms * 1000;
+    }
+    return (SimTime)std::ceil(ms * 1000.0 / speed[core_id]);
+}
+
+// Whole ms of work done in us of simulated time on core_id.
+uint32_t SimEngine::Work(uint16_t core_id, SimTime us)
+{
+    if (!speed_scaled)
+    {
+        return us / 1000;
+    }
+    return (uint32_t)(us * speed[core_id] / 1000.0);
+}
+
+void SimEngine::Run()
+{
+    while (!events.empty())
+    {
+        SimEvent e = events.top();
+        events.pop();
+        now = e.time;
+        events_processed++;
+        if (e.kind == EventKind::Resume)
+        {
+            e.handle.resume();
+        }
+        else if (e.kind == EventKind::RunEnd)
+        {
+            HandleRunEnd(e);
+        }
+        else
+        {
+            SimCore *c = &core[e.core];
+            if (c->has_pending && !ready.empty())
+            {
+                //dispatch before requeueing so the core moves on to another process
+                c->has_pending = false;
+                Dispatch(e.core);
+                Enqueue(c->pending.process, c->pending.handle, c->pending.assigned);
+            }
+            else
+            {
+                if (c->has_pending)
+                {
+                    c->has_pending = false;
+                    Enqueue(c->pending.process, c->pending.handle, c->pending.assigned);
+                }
+                Dispatch(e.core);
+            }
+        }
+        if (!backlog.empty())
+        {
+            AdmitBacklog();
+        }
+    }
+}
+
+SimTime SimEngine::Now()
+{
+    return now;
+}
+
+ScheduleAlgorithm SimEngine::GetAlgorithm()
+{
+    return algorithm;
+}
+
+uint32_t SimEngine::GetTimeSlice()
+{
+    return time_slice;
+}
+
+// The time slice is simulated time on the core; this is the work it covers.
+uint32_t SimEngine::GetSliceWork(uint16_t core_id)
+{
+    if (!speed_scaled)
+    {
+        return time_slice;
+    }
+    uint32_t work = time_slice * speed[core_id];
+    return (work < 1) ? 1 : work;
+}
+
+double SimEngine::GetCoreSpeed(uint16_t core_id)
+{
+    return speed[core_id];
+}
+
+uint16_t SimEngine::GetCores()
+{
+    return cores;
+}
+
+uint64_t SimEngine::GetEventsProcessed()
+{
+    return events_processed;
+}
+
+uint64_t SimEngine::GetCoreBusy(uint16_t core_id)
+{
+    return core[core_id].busy_us;
+}
+
+uint32_t SimEngine::GetCoreContextSwitches(uint16_t core_id)
+{
+    return core[core_id].context_switches;
+}
+
+const std::vector<SimTime>& SimEngine::GetCompletions()
+{
+    return completions;
+}
+
+uint32_t SimEngine::GetDeferred()
+{
+    return deferred;
+}
+
+uint32_t SimEngine::GetRejected()
+{
+    return rejected;
+}
+
+uint32_t SimEngine::GetPeakReady()
+{
+    return peak_ready;
+}
+
+// One coroutine per process: arrive, then alternate CPU bursts (split at RR
+// slice ends and PP preemptions) and I/O bursts until the last CPU burst.
+// Accounting goes through the same Process methods the threaded engine uses.
+SimTask ProcessLifecycle(SimEngine *sim, Process *p)
+{
+    uint64_t wait_us = 0;
+    uint32_t wait_ms = 0;
+    uint16_t core_id;
+    SimTime ready_at;
+
+    co_await sim->Delay((SimTime)p->GetStartTime() * 1000);
+    SimTime arrival = sim->Now();
+    if (!(co_await sim->Admit(p)))
+    {
+        p->SetState(Process::State::Rejected);
+        co_return;
+    }
+    while (true)
+    {
+        p->SetState(Process::State::Ready);
+        ready_at = sim->Now();
+        core_id = co_await sim->Acquire(p);
+        while (true)
+        {
+            wait_us += sim->Now() - ready_at;
+            p->CalcWaitTime(wait_us / 1000 - wait_ms);
+            wait_ms = wait_us / 1000;
+
+            p->SetState(Process::State::Running);
+            p->SetCpuCore(core_id);
+            p->CalcResponseTime((sim->Now() - arrival) / 1000);
+            uint32_t left = p->GetBurstTime() - p->GetBurstElapsed();
+            uint32_t slice = left;
+            if (sim->GetAlgorithm() == ScheduleAlgorithm::RR && sim->GetSliceWork(core_id) < left)
+            {
+                slice = sim->GetSliceWork(core_id);
+            }
+            SimTime run_start = sim->Now();
+            uint32_t ran = co_await sim->RunOn(p, core_id, slice);
+            p->SetRemainingTime(ran);
+            p->CalcCpuTime((sim->Now() - run_start) / 1000);
+            p->SetBurstElapsed(ran);
+            if (p->GetBurstElapsed() >= p->GetBurstTime())
+            {
+                break;
+            }
+
+            //slice expired or preempted by a higher priority process
+            p->UpdatePreemptions();
+            p->SetState(Process::State::Ready);
+            p->SetCpuCore(-1);
+            ready_at = sim->Now();
+            core_id = co_await sim->Preempt(p, core_id);
+        }
+        p->SetCpuCore(-1);
+        p->UpdateCurrentBurst();
+        p->SetBurstElapsed(p->GetBurstElapsed() * -1);
+        if (p->GetRemainingTime() <= 0)
+        {
+            p->SetState(Process::State::Terminated);
+            p->CalcTurnaroundTime((sim->Now() - arrival) / 1000);
+            sim->Release(core_id, false);
+            sim->Complete();
+            co_return;
+        }
+
+        p->SetState(Process::State::IO);
+        sim->Release(core_id, true);
+        co_await sim->Delay((SimTime)p->GetBurstTime() * 1000);
+        p->UpdateCurrentBurst();
+    }
+}
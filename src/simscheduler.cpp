@@ -0,0 +1,617 @@
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "configreader.h"
+#include "process.h"
+#include "simengine.h"
+#include "parallelengine.h"
+#include "statistics.h"
+#include "decisionlog.h"
+#include "reportwriter.h"
+
+typedef struct SimResults {
+    uint16_t threads;
+    uint64_t windows;
+    uint64_t events;
+    double host_time;
+    SimTime total_time;
+    std::vector<SimTime> completions;
+    std::vector<uint64_t> core_busy;
+    std::vector<uint32_t> core_switches;
+    std::vector<uint32_t> core_migrations;
+    std::vector<double> core_speeds;
+    uint32_t deferred;
+    uint32_t rejected;
+    uint32_t peak_ready;
+} SimResults;
+
+void RunGlobal(SchedulerConfig *config, std::vector<Process*> *processes, SimResults *results, DecisionLog *log);
+void RunPartitioned(SchedulerConfig *config, std::vector<Process*> *processes, SimResults *results,
+                    uint16_t threads, uint64_t seed, DecisionLog *log);
+ReportSummary SummarizeResults(const std::vector<Process*> &processes, const SimResults &results,
+                               ProcessStatistics &stats);
+void PrintResults(const std::vector<Process*> &processes, const SimResults &results, bool per_core);
+bool CompareRuns(const std::vector<Process*> &a, const SimResults &ra, const std::vector<Process*> &b, const SimResults &rb,
+                 std::ostream &out);
+void PrintDivergence(DecisionLog *log, std::ostream &out);
+void PrintDecision(const char *name, bool present, const DecisionRecord &record, std::ostream &out);
+int DiffLogs(const char *a, const char *b);
+
+int main(int argc, char **argv)
+{
+    int i;
+    const char *config_file = NULL;
+    const char *log_file = NULL;
+    const char *replay_file = NULL;
+    const char *output_file = NULL;
+    bool output = false;
+    ReportWriter::Format output_format = ReportWriter::Format::CSV;
+    bool per_core = false;
+    bool partitioned = false;
+    bool verify = false;
+    uint16_t threads = 1;
+    uint64_t seed = 1;
+    std::vector<uint16_t> bench_threads;
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--diff-log") == 0 && i + 2 < argc)
+        {
+            // verifier only, no simulation
+            return DiffLogs(argv[i + 1], argv[i + 2]);
+        }
+        else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)
+        {
+            log_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replay_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            if (!ParseReportFormat(argv[++i], &output_format))
+            {
+                std::cerr << "Error: unknown output format " << argv[i] << std::endl;
+                exit(1);
+            }
+            output = true;
+        }
+        else if (strcmp(argv[i], "--output-file") == 0 && i + 1 < argc)
+        {
+            output_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--per-core") == 0)
+        {
+            per_core = true;
+        }
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "partitioned") == 0)      partitioned = true;
+            else if (strcmp(argv[i], "global") == 0)      partitioned = false;
+            else
+            {
+                std::cerr << "Error: unknown engine " << argv[i] << std::endl;
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = std::stoi(argv[++i]);
+            partitioned = true;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = std::stoull(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--verify") == 0)
+        {
+            verify = true;
+            partitioned = true;
+        }
+        else if (strcmp(argv[i], "--bench-threads") == 0 && i + 1 < argc)
+        {
+            std::string item;
+            std::stringstream ss(argv[++i]);
+            while (std::getline(ss, item, ','))
+            {
+                bench_threads.push_back(std::stoi(item));
+            }
+            partitioned = true;
+        }
+        else if (strncmp(argv[i], "--", 2) != 0 && config_file == NULL)
+        {
+            config_file = argv[i];
+        }
+        else
+        {
+            std::cerr << "Error: unknown option " << argv[i] << std::endl;
+            exit(1);
+        }
+    }
+
+    // Ensure user entered a command line parameter for configuration file name
+    if (config_file == NULL)
+    {
+        std::cerr << "Error: must specify configuration file" << std::endl;
+        exit(1);
+    }
+
+    // Read configuration file for scheduling simulation
+    std::unique_ptr<SchedulerConfig> config = ReadConfigFile(config_file);
+
+    // A replay reruns the logged engine with the logged seed and checks every
+    // decision against the log; --log records a run for later replay
+    DecisionLog decision_log;
+    DecisionLogHeader log_header;
+    if (replay_file != NULL)
+    {
+        if (!decision_log.Open(replay_file, DecisionLog::Mode::Verify, &log_header))
+        {
+            std::cerr << "Error: cannot read decision log " << replay_file << " (missing, truncated or from another version)" << std::endl;
+            exit(1);
+        }
+        if (log_header.engine == DecisionLog::Engine::Threaded)
+        {
+            std::cerr << "Error: " << replay_file << " was recorded by osscheduler; replay it with osscheduler --replay" << std::endl;
+            exit(1);
+        }
+        if (log_header.config_hash != HashConfig(config.get()))
+        {
+            std::cerr << "Error: " << replay_file << " was recorded with a different configuration" << std::endl;
+            exit(1);
+        }
+        partitioned = (log_header.engine == DecisionLog::Engine::Partitioned);
+        threads = log_header.threads;
+        seed = log_header.seed;
+        bench_threads.clear();
+        verify = false;
+    }
+    if (partitioned || verify || !bench_threads.empty())
+    {
+        if (config->max_ready > 0)
+        {
+            std::cerr << "Error: max_ready is only supported by the global engine" << std::endl;
+            exit(1);
+        }
+        if (!config->core_speeds.empty() || config->placement != Placement::Any)
+        {
+            std::cerr << "Error: core_speeds and placement are only supported by the global engine" << std::endl;
+            exit(1);
+        }
+    }
+
+    if (log_file != NULL && replay_file == NULL)
+    {
+        log_header.cores = config->cores;
+        log_header.algorithm = config->algorithm;
+        log_header.engine = partitioned ? DecisionLog::Engine::Partitioned : DecisionLog::Engine::Global;
+        log_header.threads = threads;
+        log_header.reserved = 0;
+        log_header.seed = seed;
+        log_header.lookahead = config->migration_latency;
+        log_header.config_hash = HashConfig(config.get());
+        if (!decision_log.Open(log_file, DecisionLog::Mode::Write, &log_header))
+        {
+            std::cerr << "Error: cannot create decision log " << log_file << std::endl;
+            exit(1);
+        }
+    }
+    DecisionLog *log = (log_file != NULL || replay_file != NULL) ? &decision_log : NULL;
+
+    // Machine-readable output on stdout replaces the text report
+    FILE *output_out = stdout;
+    if (output_file != NULL)
+    {
+        output_out = fopen(output_file, "w");
+        if (output_out == NULL)
+        {
+            std::cerr << "Error: cannot open " << output_file << std::endl;
+            exit(1);
+        }
+    }
+    bool print_results = !(output && output_file == NULL);
+    // status lines must not land in a report written to stdout
+    std::ostream &status_out = print_results ? std::cout : std::cerr;
+
+    SimResults results;
+    ProcessTable table;
+    table.Create(*config);
+    std::vector<Process*> &processes = table.GetProcesses();
+    if (!bench_threads.empty())
+    {
+        // Speedup of the partitioned engine against its own single-thread run
+        double baseline = 0.0;
+        for (i = 0; i < bench_threads.size(); i++)
+        {
+            if (i > 0)
+            {
+                table.Create(*config);
+            }
+            RunPartitioned(config.get(), &processes, &results, bench_threads[i], seed, NULL);
+            if (i == 0)
+            {
+                baseline = results.host_time;
+            }
+            status_out << "Threads: " << results.threads << "  Host Time: " << results.host_time
+                       << "s  Speedup: " << baseline / results.host_time << "x  Windows: " << results.windows << "\n";
+        }
+    }
+    else if (verify)
+    {
+        // Run once sequentially and once with the requested thread count
+        ProcessTable reference_table;
+        reference_table.Create(*config);
+        std::vector<Process*> &reference = reference_table.GetProcesses();
+        SimResults reference_results;
+        RunPartitioned(config.get(), &reference, &reference_results, 1, seed, NULL);
+        RunPartitioned(config.get(), &processes, &results, (threads > 1) ? threads : 2, seed, log);
+        if (print_results)
+        {
+            PrintResults(processes, results, per_core);
+        }
+        bool same = CompareRuns(reference, reference_results, processes, results, status_out);
+        status_out << "Verify: " << results.threads << " threads " << (same ? "identical to" : "DIFFERS from")
+                   << " the 1-thread partitioned run (" << reference_results.host_time << "s vs "
+                   << results.host_time << "s host time)\n";
+        if (!same)
+        {
+            return 1;
+        }
+    }
+    else if (partitioned)
+    {
+        RunPartitioned(config.get(), &processes, &results, threads, seed, log);
+        if (print_results)
+        {
+            PrintResults(processes, results, per_core);
+        }
+    }
+    else
+    {
+        RunGlobal(config.get(), &processes, &results, log);
+        if (print_results)
+        {
+            PrintResults(processes, results, per_core);
+        }
+    }
+    if (output && bench_threads.empty())
+    {
+        ProcessStatistics stats(processes);
+        WriteReport(output_out, output_format, processes, SummarizeResults(processes, results, stats));
+    }
+    if (output_file != NULL)
+    {
+        fclose(output_out);
+    }
+
+    int status = 0;
+    if (replay_file != NULL)
+    {
+        decision_log.Close();
+        if (decision_log.Diverged())
+        {
+            PrintDivergence(&decision_log, status_out);
+            status = 1;
+        }
+        else
+        {
+            status_out << "Replay: " << decision_log.GetCount() << " decisions match " << replay_file << "\n";
+        }
+    }
+    else if (log != NULL && !decision_log.Close())
+    {
+        std::cerr << "Error: cannot write decision log " << log_file << std::endl;
+        status = 1;
+    }
+
+    return status;
+}
+
+void RunGlobal(SchedulerConfig *config, std::vector<Process*> *processes, SimResults *results, DecisionLog *log)
+{
+    int i;
+    std::chrono::high_resolution_clock::time_point host_start = std::chrono::high_resolution_clock::now();
+    SimEngine sim(config->cores, config->algorithm, config->context_switch, config->time_slice);
+    sim.SetDecisionLog(log);
+    sim.SetAging(config->aging_interval);
+    sim.SetAdmission(config->max_ready, config->admission == AdmissionPolicy::Reject);
+    sim.SetCoreSpeeds(config->core_speeds, config->placement, config->affinity_window);
+
+    // Start one lifecycle coroutine per process and run the event loop to completion
+    for (i = 0; i < processes->size(); i++)
+    {
+        sim.Spawn((*processes)[i]);
+    }
+    sim.Run();
+
+    std::chrono::duration<double> host_elapsed = std::chrono::high_resolution_clock::now() - host_start;
+    results->threads = 1;
+    results->windows = 0;
+    results->events = sim.GetEventsProcessed();
+    results->host_time = host_elapsed.count();
+    results->total_time = sim.Now();
+    results->completions = sim.GetCompletions();
+    results->core_busy.resize(sim.GetCores());
+    results->core_switches.resize(sim.GetCores());
+    results->core_migrations.assign(sim.GetCores(), 0);
+    results->core_speeds = config->core_speeds;
+    results->deferred = sim.GetDeferred();
+    results->rejected = sim.GetRejected();
+    results->peak_ready = sim.GetPeakReady();
+    for (i = 0; i < sim.GetCores(); i++)
+    {
+        results->core_busy[i] = sim.GetCoreBusy(i);
+        results->core_switches[i] = sim.GetCoreContextSwitches(i);
+    }
+}
+
+void RunPartitioned(SchedulerConfig *config, std::vector<Process*> *processes, SimResults *results,
+                    uint16_t threads, uint64_t seed, DecisionLog *log)
+{
+    int i;
+    std::chrono::high_resolution_clock::time_point host_start = std::chrono::high_resolution_clock::now();
+    ParallelEngine sim(config->cores, config->algorithm, config->context_switch, config->time_slice,
+                       threads, config->migration_latency, seed);
+    sim.SetAging(config->aging_interval);
+    if (log != NULL)
+    {
+        sim.EnableDecisionLog();
+    }
+    for (i = 0; i < processes->size(); i++)
+    {
+        sim.Spawn((*processes)[i], i);
+    }
+    sim.Run();
+    if (log != NULL)
+    {
+        sim.WriteDecisions(log);
+    }
+
+    std::chrono::duration<double> host_elapsed = std::chrono::high_resolution_clock::now() - host_start;
+    results->threads = sim.GetThreads();
+    results->windows = sim.GetWindows();
+    results->events = sim.GetEventsProcessed();
+    results->host_time = host_elapsed.count();
+    results->total_time = sim.Now();
+    results->completions = sim.GetCompletions();
+    results->core_busy.resize(sim.GetCores());
+    results->core_switches.resize(sim.GetCores());
+    results->core_migrations.resize(sim.GetCores());
+    results->core_speeds.clear();
+    results->deferred = 0;
+    results->rejected = 0;
+    // each core has its own queue; the deepest one is reported
+    results->peak_ready = 0;
+    for (i = 0; i < sim.GetCores(); i++)
+    {
+        results->core_busy[i] = sim.GetCoreBusy(i);
+        results->core_switches[i] = sim.GetCoreContextSwitches(i);
+        results->core_migrations[i] = sim.GetCoreMigrations(i);
+        results->peak_ready = std::max(results->peak_ready, sim.GetCorePeakReady(i));
+    }
+}
+
+// Utilisation is each core's busy share of the simulated time.
+static std::vector<double> CoreUtilization(const SimResults &results)
+{
+    int i;
+    double total_time = results.total_time / 1000000.0;
+    std::vector<double> core_util(results.core_busy.size());
+    for (i = 0; i < results.core_busy.size(); i++)
+    {
+        core_util[i] = (total_time == 0.0) ? 0.0 : (results.core_busy[i] / 1000000.0) / total_time * 100.0;
+    }
+    return core_util;
+}
+
+ReportSummary SummarizeResults(const std::vector<Process*> &processes, const SimResults &results,
+                               ProcessStatistics &stats)
+{
+    int i;
+    ReportSummary summary;
+    double total_time = results.total_time / 1000000.0;
+    double timeHalf = 0.0;
+    size_t completed = results.completions.size();
+    size_t half = completed / 2;
+    summary.throughput_first_half = 0.0;
+    summary.throughput_second_half = 0.0;
+    if (half > 0)
+    {
+        timeHalf = results.completions[half - 1] / 1000000.0;
+        summary.throughput_first_half = half / timeHalf;
+    }
+    if (total_time > timeHalf)
+    {
+        summary.throughput_second_half = (completed - half) / (total_time - timeHalf);
+    }
+    std::vector<double> core_util = CoreUtilization(results);
+    summary.elapsed_time = total_time;
+    summary.cpu_utilization = MeanOf(core_util.data(), core_util.size());
+    summary.throughput = (total_time == 0.0) ? 0.0 : completed / total_time;
+    summary.avg_turnaround = stats.GetTurnaroundSummary().mean;
+    summary.avg_wait = stats.GetWaitSummary().mean;
+    summary.avg_response = stats.GetResponseSummary().mean;
+    summary.context_switches = 0;
+    summary.deferred = results.deferred;
+    summary.rejected = results.rejected;
+    summary.peak_ready = results.peak_ready;
+    if (!results.core_speeds.empty())
+    {
+        summary.core_types = GroupCoreTypes(results.core_speeds.data(), core_util.data(), core_util.size());
+    }
+    for (i = 0; i < results.core_switches.size(); i++)
+    {
+        summary.context_switches += results.core_switches[i];
+    }
+    return summary;
+}
+
+void PrintResults(const std::vector<Process*> &processes, const SimResults &results, bool per_core)
+{
+    int i;
+    std::chrono::high_resolution_clock::time_point report_start = std::chrono::high_resolution_clock::now();
+    ProcessStatistics stats(processes);
+    ReportSummary summary = SummarizeResults(processes, results, stats);
+    std::vector<double> core_util = CoreUtilization(results);
+    ColumnSummary turnSummary = stats.GetTurnaroundSummary();
+    ColumnSummary waitSummary = stats.GetWaitSummary();
+
+    std::cout << "Simulated Time: " << summary.elapsed_time << "s\n";
+    std::cout << "CPU Utilization: " << summary.cpu_utilization << "%\n";
+    std::cout << "Average Throughput for First Half: " << summary.throughput_first_half << "\n";
+    std::cout << "Average Throughput for Second Half: " << summary.throughput_second_half << "\n";
+    std::cout << "Average Throughput: " << summary.throughput << "\n";
+    std::cout << "Average Turnaround Time: " << turnSummary.mean << "\n";
+    std::cout << "Average Wait Time: " << waitSummary.mean << "\n";
+    std::cout << "Turnaround Time min/max/stddev: " << turnSummary.min << " / " << turnSummary.max
+              << " / " << turnSummary.stddev << "\n";
+    std::cout << "Wait Time min/max/stddev: " << waitSummary.min << " / " << waitSummary.max
+              << " / " << waitSummary.stddev << "\n";
+    std::vector<PriorityGroup> groups = stats.GetPriorityGroups();
+    if (groups.size() > 1)
+    {
+        for (i = 0; i < groups.size(); i++)
+        {
+            std::cout << "  Priority " << (int)groups[i].priority << ": " << groups[i].count
+                      << " processes, average turnaround " << groups[i].mean_turn
+                      << ", average wait " << groups[i].mean_wait << "\n";
+        }
+    }
+    if (summary.deferred > 0 || summary.rejected > 0)
+    {
+        std::cout << "Admission: " << summary.deferred << " deferred, " << summary.rejected << " rejected, peak ready queue "
+                  << summary.peak_ready << "\n";
+    }
+    if (!results.core_speeds.empty())
+    {
+        std::vector<CoreTypeGroup> types = GroupCoreTypes(results.core_speeds.data(), core_util.data(),
+                                                          core_util.size());
+        for (i = 0; i < types.size(); i++)
+        {
+            std::cout << "  Speed " << types[i].speed << "x (" << types[i].cores << " cores): utilization "
+                      << types[i].utilization << "%\n";
+        }
+    }
+    if (per_core)
+    {
+        for (i = 0; i < results.core_busy.size(); i++)
+        {
+            std::cout << "Core " << i << ": utilization " << core_util[i]
+                      << "%, context switches " << results.core_switches[i]
+                      << ", migrations in " << results.core_migrations[i] << "\n";
+        }
+    }
+    std::cout << "Events Processed: " << results.events << " in " << results.host_time << "s host time";
+    if (results.windows > 0)
+    {
+        std::cout << " (" << results.threads << " threads, " << results.windows << " windows)";
+    }
+    std::chrono::duration<double> report_elapsed = std::chrono::high_resolution_clock::now() - report_start;
+    std::cout << "\nReport Time: " << report_elapsed.count() << "s\n";
+}
+
+bool CompareRuns(const std::vector<Process*> &a, const SimResults &ra, const std::vector<Process*> &b, const SimResults &rb,
+                 std::ostream &out)
+{
+    int i;
+    for (i = 0; i < a.size(); i++)
+    {
+        if (a[i]->GetTurnaroundTime() != b[i]->GetTurnaroundTime() || a[i]->GetWaitTime() != b[i]->GetWaitTime() ||
+            a[i]->GetCpuTime() != b[i]->GetCpuTime())
+        {
+            out << "First difference at process " << a[i]->GetPid() << " (index " << i << ")\n";
+            return false;
+        }
+    }
+    if (ra.completions != rb.completions || ra.core_busy != rb.core_busy || ra.core_switches != rb.core_switches ||
+        ra.core_migrations != rb.core_migrations || ra.events != rb.events)
+    {
+        out << "Per-core or completion statistics differ\n";
+        return false;
+    }
+    return true;
+}
+
+void PrintDivergence(DecisionLog *log, std::ostream &out)
+{
+    out << "Replay: first divergence at decision " << log->GetDivergence() << "\n";
+    PrintDecision("expected", log->HasExpected(), log->GetExpected(), out);
+    PrintDecision("got", log->HasActual(), log->GetActual(), out);
+}
+
+void PrintDecision(const char *name, bool present, const DecisionRecord &record, std::ostream &out)
+{
+    out << "  " << name << ": ";
+    if (present)
+    {
+        out << "pid " << record.pid << " on core " << record.core << " at " << record.time_us << "us\n";
+    }
+    else
+    {
+        out << "no more decisions\n";
+    }
+}
+
+// Walks both logs in step and reports the first record that differs.
+int DiffLogs(const char *a, const char *b)
+{
+    DecisionLog log_a;
+    DecisionLog log_b;
+    DecisionLogHeader header_a;
+    DecisionLogHeader header_b;
+    if (!log_a.Open(a, DecisionLog::Mode::Read, &header_a))
+    {
+        std::cerr << "Error: cannot read decision log " << a << std::endl;
+        exit(1);
+    }
+    if (!log_b.Open(b, DecisionLog::Mode::Read, &header_b))
+    {
+        std::cerr << "Error: cannot read decision log " << b << std::endl;
+        exit(1);
+    }
+    if (header_a.config_hash != header_b.config_hash)
+    {
+        std::cout << "Note: logs were recorded with different configurations\n";
+    }
+    if (header_a.engine != header_b.engine || header_a.seed != header_b.seed)
+    {
+        std::cout << "Note: logs were recorded with different engines or seeds\n";
+    }
+
+    // osscheduler stamps decisions with wall-clock time, so only the order counts
+    bool compare_time = header_a.engine != DecisionLog::Engine::Threaded &&
+                        header_b.engine != DecisionLog::Engine::Threaded;
+    if (!compare_time)
+    {
+        std::cout << "Note: comparing dispatch order only (osscheduler log)\n";
+    }
+
+    uint64_t n = 0;
+    DecisionRecord record_a;
+    DecisionRecord record_b;
+    while (true)
+    {
+        bool has_a = log_a.Next(&record_a);
+        bool has_b = log_b.Next(&record_b);
+        if (!has_a && !has_b)
+        {
+            break;
+        }
+        if (has_a != has_b || (compare_time && record_a.time_us != record_b.time_us) || record_a.pid != record_b.pid ||
+            record_a.core != record_b.core)
+        {
+            std::cout << "First divergence at decision " << n << "\n";
+            PrintDecision(a, has_a, record_a, std::cout);
+            PrintDecision(b, has_b, record_b, std::cout);
+            return 1;
+        }
+        n++;
+    }
+    std::cout << "Logs identical (" << n << " decisions)\n";
+    return 0;
+}
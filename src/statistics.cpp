@@ -0,0 +1,192 @@
+#include "statistics.h"
+#include <cmath>
+#include <algorithm>
+
+// Rejected processes never entered the system and are left out, as are the
+// response times (-1) of processes that were never dispatched.
+ProcessStatistics::ProcessStatistics(const std::vector<Process*> &processes)
+{
+    size_t i;
+    size_t n = 0;
+    size_t responded = 0;
+    turn_ms.resize(processes.size());
+    wait_ms.resize(processes.size());
+    cpu_ms.resize(processes.size());
+    response_ms.resize(processes.size());
+    priority.resize(processes.size());
+    for (i = 0; i < processes.size(); i++)
+    {
+        Process *p = processes[i];
+        if (p->GetState() == Process::State::Rejected)
+        {
+            continue;
+        }
+        turn_ms[n] = p->GetTurnaroundMs();
+        wait_ms[n] = p->GetWaitMs();
+        cpu_ms[n] = p->GetCpuMs();
+        if (p->GetResponseMs() >= 0)
+        {
+            response_ms[responded++] = p->GetResponseMs();
+        }
+        priority[n] = p->GetPriority();
+        n++;
+    }
+    turn_ms.resize(n);
+    wait_ms.resize(n);
+    cpu_ms.resize(n);
+    response_ms.resize(responded);
+    priority.resize(n);
+}
+
+size_t ProcessStatistics::GetCount()
+{
+    return turn_ms.size();
+}
+
+ColumnSummary ProcessStatistics::GetTurnaroundSummary()
+{
+    return SummarizeColumn(turn_ms.data(), turn_ms.size());
+}
+
+ColumnSummary ProcessStatistics::GetWaitSummary()
+{
+    return SummarizeColumn(wait_ms.data(), wait_ms.size());
+}
+
+ColumnSummary ProcessStatistics::GetCpuSummary()
+{
+    return SummarizeColumn(cpu_ms.data(), cpu_ms.size());
+}
+
+ColumnSummary ProcessStatistics::GetResponseSummary()
+{
+    return SummarizeColumn(response_ms.data(), response_ms.size());
+}
+
+// Only the priorities that occur are returned, in ascending order.
+std::vector<PriorityGroup> ProcessStatistics::GetPriorityGroups()
+{
+    size_t i;
+    uint64_t count[256] = {0};
+    int64_t turn[256] = {0};
+    int64_t wait[256] = {0};
+    int64_t cpu[256] = {0};
+    size_t n = priority.size();
+    for (i = 0; i < n; i++)
+    {
+        uint8_t p = priority[i];
+        count[p]++;
+        turn[p] += turn_ms[i];
+        wait[p] += wait_ms[i];
+        cpu[p] += cpu_ms[i];
+    }
+
+    std::vector<PriorityGroup> groups;
+    for (i = 0; i < 256; i++)
+    {
+        if (count[i] == 0)
+        {
+            continue;
+        }
+        PriorityGroup g;
+        g.priority = i;
+        g.count = count[i];
+        g.mean_turn = (double)turn[i] / count[i] / 1000.0;
+        g.mean_wait = (double)wait[i] / count[i] / 1000.0;
+        g.mean_cpu = (double)cpu[i] / count[i] / 1000.0;
+        groups.push_back(g);
+    }
+    return groups;
+}
+
+// Integer sum/min/max in one pass, then a second pass for the variance about
+// the mean. Loops are branch-free so they vectorise; the floating point
+// reduction is marked simd so it may be reassociated (needs -fopenmp-simd).
+ColumnSummary SummarizeColumn(const int32_t *values, size_t n)
+{
+    size_t i;
+    ColumnSummary summary;
+    summary.count = n;
+    if (n == 0)
+    {
+        summary.sum = summary.mean = summary.min = summary.max = summary.variance = summary.stddev = 0.0;
+        return summary;
+    }
+
+    int64_t sum = 0;
+    int32_t lo = values[0];
+    int32_t hi = values[0];
+    for (i = 0; i < n; i++)
+    {
+        sum += values[i];
+        lo = (values[i] < lo) ? values[i] : lo;
+        hi = (values[i] > hi) ? values[i] : hi;
+    }
+    double mean = (double)sum / n;
+
+    double squares = 0.0;
+#pragma omp simd reduction(+:squares)
+    for (i = 0; i < n; i++)
+    {
+        double d = values[i] - mean;
+        squares += d * d;
+    }
+
+    summary.sum = sum / 1000.0;
+    summary.mean = mean / 1000.0;
+    summary.min = lo / 1000.0;
+    summary.max = hi / 1000.0;
+    summary.variance = squares / n / 1000000.0;
+    summary.stddev = std::sqrt(summary.variance);
+    return summary;
+}
+
+double MeanOf(const double *values, size_t n)
+{
+    size_t i;
+    double sum = 0.0;
+    if (n == 0)
+    {
+        return 0.0;
+    }
+#pragma omp simd reduction(+:sum)
+    for (i = 0; i < n; i++)
+    {
+        sum += values[i];
+    }
+    return sum / n;
+}
+
+// Core counts are small, so a linear search for each core's type is fine.
+std::vector<CoreTypeGroup> GroupCoreTypes(const double *speeds, const double *utilization, size_t n)
+{
+    size_t i, j;
+    std::vector<CoreTypeGroup> groups;
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < groups.size(); j++)
+        {
+            if (groups[j].speed == speeds[i])
+            {
+                break;
+            }
+        }
+        if (j == groups.size())
+        {
+            CoreTypeGroup g;
+            g.speed = speeds[i];
+            g.cores = 0;
+            g.utilization = 0.0;
+            groups.push_back(g);
+        }
+        groups[j].cores++;
+        groups[j].utilization += utilization[i];
+    }
+    for (j = 0; j < groups.size(); j++)
+    {
+        groups[j].utilization /= groups[j].cores;
+    }
+    std::sort(groups.begin(), groups.end(),
+              [](const CoreTypeGroup &a, const CoreTypeGroup &b) { return a.speed > b.speed; });
+    return groups;
+}
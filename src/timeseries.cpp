@@ -0,0 +1,171 @@
+#include "timeseries.h"
+#include <algorithm>
+
+TimeSeries::TimeSeries(uint32_t capacity, uint16_t cores, uint32_t window_ms)
+{
+    int i;
+    this->capacity = (capacity == 0) ? 1 : capacity;
+    this->cores = cores;
+    this->window_ms = (window_ms == 0) ? 1 : window_ms;
+    head = 0;
+    count = 0;
+    dropped = 0;
+    samples = new TimeSample[this->capacity];
+    core_util = new double[this->capacity * cores];
+    prev_busy_us = new uint64_t[cores];
+    for (i = 0; i < cores; i++)
+    {
+        prev_busy_us[i] = 0;
+    }
+    prev_completed = 0;
+    prev_context_switches = 0;
+    prev_window_end_ms = 0;
+    format = TimeSeries::Format::CSV;
+    stream = NULL;
+}
+
+TimeSeries::~TimeSeries()
+{
+    delete[] samples;
+    delete[] core_util;
+    delete[] prev_busy_us;
+}
+
+uint32_t TimeSeries::GetWindow()
+{
+    return window_ms;
+}
+
+bool TimeSeries::WindowElapsed(uint32_t now_ms)
+{
+    return now_ms - prev_window_end_ms >= window_ms;
+}
+
+void TimeSeries::Record(uint32_t now_ms, uint32_t completed, uint32_t ready_queue_len,
+                        const uint64_t *busy_us, uint32_t context_switches)
+{
+    int i;
+    uint32_t index = head;
+    uint32_t span_ms = now_ms - prev_window_end_ms;
+    double span = (span_ms == 0) ? 0.001 : span_ms / 1000.0;
+    TimeSample *s = &samples[index];
+
+    s->window_start_ms = prev_window_end_ms;
+    s->window_end_ms = now_ms;
+    s->completed = completed - prev_completed;
+    s->ready_queue_len = ready_queue_len;
+    s->context_switches = context_switches - prev_context_switches;
+    s->throughput = s->completed / span;
+    s->context_switch_rate = s->context_switches / span;
+    // busy time is credited when a tick ends and the span is whole
+    // milliseconds, so a fully busy core can come out slightly over 100%
+    for (i = 0; i < cores; i++)
+    {
+        core_util[index * cores + i] = std::min(((busy_us[i] - prev_busy_us[i]) / 1000000.0) / span * 100.0, 100.0);
+        prev_busy_us[i] = busy_us[i];
+    }
+    prev_completed = completed;
+    prev_context_switches = context_switches;
+    prev_window_end_ms = now_ms;
+
+    // oldest sample is overwritten once the ring is full
+    head = (head + 1) % capacity;
+    if (count < capacity)
+    {
+        count++;
+    }
+    else
+    {
+        dropped++;
+    }
+
+    if (stream != NULL)
+    {
+        WriteSample(stream, index, false);
+        fflush(stream);
+    }
+}
+
+void TimeSeries::SetStream(FILE *out, Format fmt)
+{
+    stream = out;
+    format = fmt;
+    if (stream != NULL && format == TimeSeries::Format::CSV)
+    {
+        WriteCsvHeader(stream);
+    }
+}
+
+void TimeSeries::WriteCsvHeader(FILE *out)
+{
+    int i;
+    fprintf(out, "window_start_ms,window_end_ms,completed,throughput,ready_queue_len,context_switches,context_switch_rate");
+    for (i = 0; i < cores; i++)
+    {
+        fprintf(out, ",core%d_util", i);
+    }
+    fprintf(out, "\n");
+}
+
+void TimeSeries::WriteSample(FILE *out, uint32_t index, bool first)
+{
+    int i;
+    TimeSample *s = &samples[index];
+    if (format == TimeSeries::Format::CSV)
+    {
+        fprintf(out, "%u,%u,%u,%.3f,%u,%u,%.3f", s->window_start_ms, s->window_end_ms, s->completed,
+                s->throughput, s->ready_queue_len, s->context_switches, s->context_switch_rate);
+        for (i = 0; i < cores; i++)
+        {
+            fprintf(out, ",%.2f", core_util[index * cores + i]);
+        }
+        fprintf(out, "\n");
+    }
+    else
+    {
+        // streamed samples are written one object per line; Write() wraps them in an array
+        if (stream == NULL)
+        {
+            fprintf(out, first ? "  " : ",\n  ");
+        }
+        fprintf(out, "{\"window_start_ms\": %u, \"window_end_ms\": %u, \"completed\": %u, \"throughput\": %.3f, "
+                "\"ready_queue_len\": %u, \"context_switches\": %u, \"context_switch_rate\": %.3f, \"core_util\": [",
+                s->window_start_ms, s->window_end_ms, s->completed, s->throughput,
+                s->ready_queue_len, s->context_switches, s->context_switch_rate);
+        for (i = 0; i < cores; i++)
+        {
+            fprintf(out, (i == 0) ? "%.2f" : ", %.2f", core_util[index * cores + i]);
+        }
+        fprintf(out, (stream == NULL) ? "]}" : "]}\n");
+    }
+}
+
+void TimeSeries::Write(FILE *out, Format fmt)
+{
+    uint32_t i;
+    uint32_t oldest = (head + capacity - count) % capacity;
+    FILE *saved_stream = stream;
+    Format saved_format = format;
+
+    stream = NULL;
+    format = fmt;
+    if (format == TimeSeries::Format::CSV)
+    {
+        WriteCsvHeader(out);
+        for (i = 0; i < count; i++)
+        {
+            WriteSample(out, (oldest + i) % capacity, i == 0);
+        }
+    }
+    else
+    {
+        fprintf(out, "{\"window_ms\": %u, \"dropped\": %u, \"samples\": [\n", window_ms, dropped);
+        for (i = 0; i < count; i++)
+        {
+            WriteSample(out, (oldest + i) % capacity, i == 0);
+        }
+        fprintf(out, "\n]}\n");
+    }
+    stream = saved_stream;
+    format = saved_format;
+}